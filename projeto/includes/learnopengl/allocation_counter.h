@@ -0,0 +1,45 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <atomic>
+#include <cstddef>
+
+// Counts every heap allocation made through the global operator new, so a frame can check it allocated nothing.
+// The replacement operators doing the counting are defined in allocation_counter.cpp, built into the executable;
+// this header only reads the counts and can be included anywhere. Memory taken with malloc (by the driver,
+// stb_image, assimp's C code...) isn't seen
+
+struct AllocationStats {
+    size_t count;
+    size_t bytes;
+};
+
+inline std::atomic<size_t>& allocationCount()
+{
+    static std::atomic<size_t> count(0);
+    return count;
+}
+
+inline std::atomic<size_t>& allocationBytes()
+{
+    static std::atomic<size_t> bytes(0);
+    return bytes;
+}
+
+// Returns the allocations made since the program started; subtract two of these to measure a section
+inline AllocationStats GetAllocationStats()
+{
+    AllocationStats stats;
+    stats.count = allocationCount().load(std::memory_order_relaxed);
+    stats.bytes = allocationBytes().load(std::memory_order_relaxed);
+    return stats;
+}
+
+inline AllocationStats operator-(const AllocationStats &a, const AllocationStats &b)
+{
+    AllocationStats stats;
+    stats.count = a.count - b.count;
+    stats.bytes = a.bytes - b.bytes;
+    return stats;
+}
+#endif
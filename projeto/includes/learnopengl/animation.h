@@ -0,0 +1,1398 @@
+#ifndef ANIMATION_H
+#define ANIMATION_H
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
+#include <glm/gtx/dual_quaternion.hpp>
+
+#include <learnopengl/spline.h>
+#include <learnopengl/worker_pool.h>
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <mutex>
+#include <vector>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define ANIMATION_SSE 1
+#endif
+
+// Marks a missing operation or instance in the index arrays below
+const unsigned int ANIMATION_NONE = 0xFFFFFFFF;
+
+// Animation operations queued on an instance. Each one runs for a duration in seconds, starting at the animation
+// system's current time or when the previous one of the same kind ends, whichever is later; a duration of 0
+// applies it at once
+
+struct TranslationOp {
+    glm::vec3 target;
+};
+
+struct ScaleOp {
+    glm::vec3 target;
+};
+
+struct AxisRotationOp {
+    float angle;        // radians
+    glm::vec3 axis;
+};
+
+// turns the instance to face point, then rotates it angle radians around point
+struct RoundPointOp {
+    float angle;
+    glm::vec3 point;
+};
+
+// shears the other two axes along axis (0 = x, 1 = y, 2 = z), from 0 to the given values
+struct ShearOp {
+    int axis;
+    float firstValue;
+    float secondValue;
+};
+
+// cubic curve moving the instance from p0 to p3
+struct CurveOp {
+    glm::vec3 p0;
+    glm::vec3 p1;
+    glm::vec3 p2;
+    glm::vec3 p3;
+};
+
+// moves the instance along a spline kept by the animation system, from its start to its end
+struct SplineOp {
+    unsigned int spline;
+};
+
+// Cubic Bézier curve Equation, in Bernstein form. The animations evaluate it as a BezierPolynomial
+inline glm::vec3 BezierPoint(const CurveOp &b, float t)
+{
+    return (float)pow(1-t, 3) * b.p0 +
+           3 * (float)pow(1-t, 2) * t * b.p1 +
+           3 * (1-t) * (float)pow(t, 2) * b.p2 +
+           (float)pow(t, 3) * b.p3;
+}
+
+// The Bézier curve's Bernstein form multiplied out
+inline CubicPolynomial BezierPolynomial(const CurveOp &b)
+{
+    return SegmentPolynomial(SPLINE_BEZIER, b.p0, b.p1, b.p2, b.p3);
+}
+
+// entries of the arc length tables, the first at the start of the curve and the last at its end
+const int ARC_LENGTH_SAMPLES = 32;
+
+// Fills parameter with where the curve is at evenly spaced distances along it, measured on a fine polyline
+inline void ArcLengthTable(const CubicPolynomial &curve, float parameter[ARC_LENGTH_SAMPLES])
+{
+    const int steps = 256;
+    float lengths[steps + 1];
+    lengths[0] = 0.0f;
+    glm::vec3 last = curve.d;
+    for(int i = 1; i <= steps; i++)
+    {
+        glm::vec3 point = PolynomialPoint(curve, (float)i / steps);
+        lengths[i] = lengths[i - 1] + glm::length(point - last);
+        last = point;
+    }
+    int i = 0;
+    for(int k = 0; k < ARC_LENGTH_SAMPLES; k++)
+    {
+        float target = lengths[steps] * k / (ARC_LENGTH_SAMPLES - 1);
+        while(i < steps - 1 && lengths[i + 1] < target)
+            i++;
+        float segment = lengths[i + 1] - lengths[i];
+        float fraction = segment > 0.0f ? (target - lengths[i]) / segment : 0.0f;
+        parameter[k] = (i + glm::clamp(fraction, 0.0f, 1.0f)) / steps;
+    }
+    parameter[0] = 0.0f;
+    parameter[ARC_LENGTH_SAMPLES - 1] = 1.0f;
+}
+
+// A Bézier operation as it's kept: the curve as a polynomial and, to run it at constant speed, its arc length table
+struct BezierOp {
+    CubicPolynomial curve;
+    glm::vec3 end;                              // p3, exactly
+    bool constantSpeed;
+    float parameter[ARC_LENGTH_SAMPLES];        // only filled when constantSpeed
+};
+
+inline BezierOp BezierOperation(const CurveOp &b, bool constantSpeed)
+{
+    BezierOp op;
+    op.curve = BezierPolynomial(b);
+    op.end = b.p3;
+    op.constantSpeed = constantSpeed;
+    if(constantSpeed)
+        ArcLengthTable(op.curve, op.parameter);
+    return op;
+}
+
+// the point percentage of the way through the operation, in time. At constant speed that's also percentage of the
+// way along the curve: the parameter comes from the table, interpolated between the two entries around it
+inline glm::vec3 BezierOpPoint(const BezierOp &b, float percentage)
+{
+    float t = percentage;
+    if(b.constantSpeed)
+    {
+        float x = percentage * (ARC_LENGTH_SAMPLES - 1);
+        int k = std::min(std::max((int)x, 0), ARC_LENGTH_SAMPLES - 2);
+        t = b.parameter[k] + (x - k) * (b.parameter[k + 1] - b.parameter[k]);
+    }
+    return PolynomialPoint(b.curve, t);
+}
+
+// The kinds of operations, in the order they're applied at any instant: the curves and translations set the
+// position, then come shear, scale, the rotation around an axis and last the rotation around a point
+enum Animation_Kind {
+    ANIMATION_SPLINE,
+    ANIMATION_BEZIER,
+    ANIMATION_TRANSLATION,
+    ANIMATION_SHEAR,
+    ANIMATION_SCALE,
+    ANIMATION_ROTATION,
+    ANIMATION_ROUND_POINT
+};
+
+const int ANIMATION_KIND_COUNT = 7;
+
+// When the operations of one kind run, for every instance, in parallel arrays. The operations of an instance
+// are chained in the order they run
+class OperationTimes
+{
+public:
+    std::vector<float> start;
+    std::vector<float> end;
+    std::vector<unsigned int> next;     // next operation of the same instance
+    std::vector<glm::vec3> from;        // the value a translation or scale starts from, found when compiling
+
+    // Fraction of the operation done at time; the ones taking no time are done at once
+    float Progress(unsigned int index, float time) const
+    {
+        if(end[index] <= start[index])
+            return 1;
+        return (time - start[index]) / (end[index] - start[index]);
+    }
+
+    // frees a chain of operations
+    void Free(unsigned int first)
+    {
+        for(unsigned int i = first; i != ANIMATION_NONE; i = next[i])
+            freeOps.push_back(i);
+    }
+
+protected:
+    std::vector<unsigned int> freeOps;
+};
+
+// The operations themselves, indexed like their times
+template<typename Op>
+class OperationPool : public OperationTimes
+{
+public:
+    std::vector<Op> op;
+
+    unsigned int Add(const Op &operation, float startTime, float endTime)
+    {
+        unsigned int index;
+        if(!freeOps.empty())
+        {
+            index = freeOps.back();
+            freeOps.pop_back();
+        }
+        else
+        {
+            index = op.size();
+            op.push_back(operation);
+            start.push_back(0.0f);
+            end.push_back(0.0f);
+            next.push_back(ANIMATION_NONE);
+            from.push_back(glm::vec3(0.0f));
+        }
+        op[index] = operation;
+        start[index] = startTime;
+        end[index] = endTime;
+        next[index] = ANIMATION_NONE;
+        return index;
+    }
+
+    // copies a chain of operations, returning the first copy
+    unsigned int Copy(unsigned int first)
+    {
+        unsigned int copyFirst = ANIMATION_NONE, previous = ANIMATION_NONE;
+        for(unsigned int i = first; i != ANIMATION_NONE; i = next[i])
+        {
+            // Add may move the arrays
+            Op operation = op[i];
+            glm::vec3 value = from[i];
+            unsigned int copy = Add(operation, start[i], end[i]);
+            from[copy] = value;
+            if(previous == ANIMATION_NONE)
+                copyFirst = copy;
+            else
+                next[previous] = copy;
+            previous = copy;
+        }
+        return copyFirst;
+    }
+};
+
+// What an instance's world matrix is made of, besides the rotations running
+struct AnimationPose {
+    glm::vec3 position;
+    glm::vec3 scale;
+    glm::quat orientation;      // turns +y to the instance's up and +z to its front
+    int shearAxis;
+    float shearFirst;
+    float shearSecond;
+};
+
+// An instance's pose at a time, and the operations running or still to run from then on
+struct Keyframe {
+    float time;
+    AnimationPose pose;
+    unsigned int current[ANIMATION_KIND_COUNT];     // per kind, the first operation not done by time
+};
+
+// Animates every instance in the program.
+//
+// Queuing an operation places it at absolute times on the instance's timeline, which is compiled into keyframes:
+// one wherever an operation starts or ends, holding the pose then and the operations running. The pose at any time
+// is the keyframe before it plus the running operations evaluated in closed form, so it doesn't depend on which
+// times were evaluated before: updates can jump to any time, backwards included, and give the same result at any
+// frame rate. The keyframe is found from the one used last, or by binary search.
+//
+// Instances whose timeline is over aren't evaluated at all, and the pose of each instance is written to arrays
+// indexed by its id, from which the world matrices are composed in one pass. Both passes can be split across
+// worker threads. A fixed step simulation calls Step instead of Update, and Interpolate every frame rendered to
+// blend the poses of the last two steps. The world matrix is
+//   translate * shear * scale * orientation, or roundPointRotation * translate * shear * scale
+// while a rotation around a point is running. Orientations are kept as quaternions, renormalized whenever one is
+// turned, and only become matrices when the world matrix is composed; a rotation around a point is a rigid motion
+// kept as a dual quaternion.
+//
+// An instance can be parented to another: its world matrix is then its parent's times the matrix of its own pose.
+// The instances with a parent are kept breadth first, each after its parent, and after the instances that changed
+// are composed one pass down that list multiplies again those whose own matrix or parent's changed
+class AnimationSystem
+{
+public:
+    // whether the world matrices are composed with SSE, when the compiler targets it. The scalar path gives the
+    // same matrices, it's kept to compare against
+    bool Simd;
+    // when set, evaluating the instances and composing their matrices are split across these threads. Operations
+    // must not be queued while an update runs
+    WorkerPool *Workers;
+
+    AnimationSystem() : Simd(true), Workers(nullptr), time(0.0f), hierarchyChanged(false), staleAnimated(false), movingRoots(0) {}
+
+    // creates an instance at the origin, returns its id
+    unsigned int Create()
+    {
+        unsigned int id;
+        if(!freeIds.empty())
+        {
+            id = freeIds.back();
+            freeIds.pop_back();
+            // the destroyed instance may still be listed as animated; the entry is dropped before the next update
+            if(animated[id])
+            {
+                animated[id] = false;
+                staleAnimated = true;
+            }
+            orbiting[id] = false;
+        }
+        else
+        {
+            id = timelines.size();
+            timelines.push_back(Timeline());
+            position.push_back(glm::vec3(0.0f));
+            scale.push_back(glm::vec3(1.0f));
+            orientation.push_back(glm::quat());
+            shearAxis.push_back(0);
+            shearFirst.push_back(0.0f);
+            shearSecond.push_back(0.0f);
+            orbiting.push_back(false);
+            orbits.push_back(glm::dualquat());
+            alive.push_back(false);
+            animated.push_back(false);
+            created.push_back(false);
+            matrices.push_back(glm::mat4(1.0f));
+            locals.push_back(glm::mat4(1.0f));
+            parents.push_back(ANIMATION_NONE);
+            worldChanged.push_back(false);
+        }
+        Timeline &timeline = timelines[id];
+        Keyframe start;
+        // before anything can start
+        start.time = -FLT_MAX;
+        start.pose.position = glm::vec3(0.0f);
+        start.pose.scale = glm::vec3(1.0f);
+        start.pose.orientation = glm::quat();
+        start.pose.shearAxis = 0;
+        start.pose.shearFirst = start.pose.shearSecond = 0.0f;
+        for(int kind = 0; kind < ANIMATION_KIND_COUNT; kind++)
+        {
+            start.current[kind] = ANIMATION_NONE;
+            timeline.first[kind] = timeline.last[kind] = ANIMATION_NONE;
+        }
+        timeline.keyframes.assign(1, start);
+        timeline.written = ANIMATION_NONE;
+        moveCursor(timeline, 0);
+        alive[id] = true;
+        glm::dualquat orbit;
+        bool aroundPoint, poseChanged;
+        sample(id, time, orbit, aroundPoint, poseChanged);
+        compose(id, nullptr);
+        if(!created[id])
+        {
+            created[id] = true;
+            createdIds.push_back(id);
+        }
+        return id;
+    }
+
+    // creates an instance with the same timeline as another one
+    unsigned int Clone(unsigned int from)
+    {
+        unsigned int id = Create();
+        Timeline &source = timelines[from];
+        Timeline &copy = timelines[id];
+        copy.first[ANIMATION_SPLINE] = splineOps.Copy(source.first[ANIMATION_SPLINE]);
+        for(unsigned int i = copy.first[ANIMATION_SPLINE]; i != ANIMATION_NONE; i = splineOps.next[i])
+            splineReferences[splineOps.op[i].spline]++;
+        copy.first[ANIMATION_BEZIER] = beziers.Copy(source.first[ANIMATION_BEZIER]);
+        copy.first[ANIMATION_TRANSLATION] = translations.Copy(source.first[ANIMATION_TRANSLATION]);
+        copy.first[ANIMATION_SHEAR] = shears.Copy(source.first[ANIMATION_SHEAR]);
+        copy.first[ANIMATION_SCALE] = scales.Copy(source.first[ANIMATION_SCALE]);
+        copy.first[ANIMATION_ROTATION] = rotations.Copy(source.first[ANIMATION_ROTATION]);
+        copy.first[ANIMATION_ROUND_POINT] = roundPoints.Copy(source.first[ANIMATION_ROUND_POINT]);
+        // the keyframes point at the operations at the same places in the copied chains
+        copy.keyframes = source.keyframes;
+        for(int kind = 0; kind < ANIMATION_KIND_COUNT; kind++)
+        {
+            copy.last[kind] = ANIMATION_NONE;
+            for(unsigned int i = copy.first[kind]; i != ANIMATION_NONE; i = times(kind).next[i])
+                copy.last[kind] = i;
+            for(size_t k = 0; k < copy.keyframes.size(); k++)
+                copy.keyframes[k].current[kind] = copyOf(kind, source.first[kind], copy.first[kind], source.keyframes[k].current[kind]);
+        }
+        copy.written = ANIMATION_NONE;
+        moveCursor(copy, source.cursor);
+        position[id] = position[from];
+        scale[id] = scale[from];
+        orientation[id] = orientation[from];
+        shearAxis[id] = shearAxis[from];
+        shearFirst[id] = shearFirst[from];
+        shearSecond[id] = shearSecond[from];
+        orbiting[id] = orbiting[from];
+        orbits[id] = orbits[from];
+        matrices[id] = matrices[from];
+        // a sibling of the source
+        if(parents[from] != ANIMATION_NONE)
+            SetParent(id, parents[from]);
+        if(animated[from])
+            setAnimated(id);
+        return id;
+    }
+
+    void Destroy(unsigned int id)
+    {
+        Timeline &timeline = timelines[id];
+        for(unsigned int i = timeline.first[ANIMATION_SPLINE]; i != ANIMATION_NONE; i = splineOps.next[i])
+            ReleaseSpline(splineOps.op[i].spline);
+        for(int kind = 0; kind < ANIMATION_KIND_COUNT; kind++)
+            times(kind).Free(timeline.first[kind]);
+        std::vector<Keyframe>().swap(timeline.keyframes);
+        // the children lose their parent, their own pose taken in the world again
+        if(hierarchyChanged)
+            flatten();
+        for(size_t i = 0; i < links.size(); i++)
+            if(links[i].parent == id)
+                SetParent(links[i].instance, ANIMATION_NONE);
+        SetParent(id, ANIMATION_NONE);
+        alive[id] = false;
+        freeIds.push_back(id);
+    }
+
+    // Makes parent's world matrix the frame the instance's pose is in, or with ANIMATION_NONE the world again. The
+    // world matrices change on the next update. Returns false, changing nothing, if parent is the instance itself or
+    // one of its descendants
+    bool SetParent(unsigned int id, unsigned int parent)
+    {
+        for(unsigned int up = parent; up != ANIMATION_NONE; up = parents[up])
+            if(up == id)
+                return false;
+        if(parents[id] == parent)
+            return true;
+        parents[id] = parent;
+        reparented.push_back(id);
+        hierarchyChanged = true;
+        return true;
+    }
+
+    unsigned int Parent(unsigned int id) const
+    {
+        return parents[id];
+    }
+
+    void Translate(unsigned int id, const TranslationOp &op, float duration)    { queue(ANIMATION_TRANSLATION, translations, id, op, duration); }
+    void Scale(unsigned int id, const ScaleOp &op, float duration)              { queue(ANIMATION_SCALE, scales, id, op, duration); }
+    void RotateAround(unsigned int id, const RoundPointOp &op, float duration)  { queue(ANIMATION_ROUND_POINT, roundPoints, id, op, duration); }
+    void Shear(unsigned int id, const ShearOp &op, float duration)              { queue(ANIMATION_SHEAR, shears, id, op, duration); }
+
+    // keeps a spline for instances to follow, returning its id. It stays until ReleaseSpline and every operation
+    // following it are gone
+    unsigned int AddSpline(const Spline &spline)
+    {
+        unsigned int index;
+        if(!freeSplines.empty())
+        {
+            index = freeSplines.back();
+            freeSplines.pop_back();
+            splines[index] = spline;
+        }
+        else
+        {
+            index = splines.size();
+            splines.push_back(spline);
+            splineReferences.push_back(0);
+        }
+        splineReferences[index] = 1;
+        return index;
+    }
+
+    void ReleaseSpline(unsigned int spline)
+    {
+        if(--splineReferences[spline] == 0)
+        {
+            splines[spline] = Spline();
+            freeSplines.push_back(spline);
+        }
+    }
+
+    void FollowSpline(unsigned int id, unsigned int spline, float duration)
+    {
+        splineReferences[spline]++;
+        SplineOp op = {spline};
+        queue(ANIMATION_SPLINE, splineOps, id, op, duration);
+    }
+
+    // the Catmull-Rom curve through the four points
+    void BSpline(unsigned int id, const CurveOp &op, float duration)
+    {
+        glm::vec3 points[4] = {op.p0, op.p1, op.p2, op.p3};
+        unsigned int spline = AddSpline(Spline(std::vector<glm::vec3>(points, points + 4), SPLINE_CATMULL_ROM));
+        FollowSpline(id, spline, duration);
+        ReleaseSpline(spline);
+    }
+
+    void Rotate(unsigned int id, const AxisRotationOp &op, float duration)
+    {
+        AxisRotationOp rotation = {op.angle, glm::normalize(op.axis)};
+        queue(ANIMATION_ROTATION, rotations, id, rotation, duration);
+    }
+
+    // constantSpeed moves along the curve at the same speed all the way, rather than at the curve's own pace
+    void Bezier(unsigned int id, const CurveOp &op, float duration, bool constantSpeed = false)
+    {
+        queue(ANIMATION_BEZIER, beziers, id, BezierOperation(op, constantSpeed), duration);
+    }
+
+    // evaluates every instance at currentTime, which may be before the last update, and recomputes the world matrices
+    // of those whose pose changed. Idle instances cost nothing
+    void Update(float currentTime)
+    {
+        dropStale();
+        // going back, the instances whose timeline was over may be animated again
+        if(currentTime < time)
+            for(unsigned int id = 0; id < timelines.size(); id++)
+                if(alive[id] && timelines[id].keyframes.size() > 1)
+                    setAnimated(id);
+        time = currentTime;
+
+        done.resize(animatedIds.size());
+        moved.resize(animatedIds.size());
+        parallelFor(animatedIds.size(), 256, [this](unsigned int begin, unsigned int end) {
+            for(unsigned int i = begin; i < end; i++)
+            {
+                unsigned int id = animatedIds[i];
+                if(!alive[id])
+                {
+                    done[i] = true;
+                    moved[i] = false;
+                    continue;
+                }
+                glm::dualquat orbit;
+                bool aroundPoint, poseChanged;
+                done[i] = sample(id, time, orbit, aroundPoint, poseChanged);
+                // those rotating around a point are composed apart
+                moved[i] = poseChanged && !aroundPoint;
+                orbiting[id] = aroundPoint;
+                if(aroundPoint)
+                {
+                    orbits[id] = orbit;
+                    std::lock_guard<std::mutex> lock(specialsMutex);
+                    specials.push_back(Special());
+                    specials.back().instance = id;
+                    specials.back().orbit = orbit;
+                }
+            }
+        });
+        unsigned int kept = 0;
+        movedIds.clear();
+        for(unsigned int i = 0; i < animatedIds.size(); i++)
+        {
+            if(moved[i])
+                movedIds.push_back(animatedIds[i]);
+            if(done[i])
+                animated[animatedIds[i]] = false;
+            else
+                animatedIds[kept++] = animatedIds[i];
+        }
+        animatedIds.resize(kept);
+        // those given or taken a parent compose their pose into the other matrix, each listed once
+        if(!reparented.empty())
+        {
+            for(size_t i = 0; i < movedIds.size(); i++)
+                worldChanged[movedIds[i]] = true;
+            for(size_t i = 0; i < reparented.size(); i++)
+                if(!worldChanged[reparented[i]])
+                {
+                    worldChanged[reparented[i]] = true;
+                    movedIds.push_back(reparented[i]);
+                }
+            for(size_t i = 0; i < movedIds.size(); i++)
+                worldChanged[movedIds[i]] = false;
+            reparented.clear();
+        }
+
+        parallelFor(movedIds.size(), 1024, [this](unsigned int begin, unsigned int end) {
+            composeIds(&movedIds[begin], end - begin);
+        });
+        // the few instances rotating around a point
+        for(size_t i = 0; i < specials.size(); i++)
+        {
+            compose(specials[i].instance, &specials[i].orbit);
+            movedIds.push_back(specials[i].instance);
+        }
+        specials.clear();
+        if(!links.empty() || hierarchyChanged)
+            propagate();
+    }
+
+    // Update for a fixed step simulation: the poses at the step before are kept, for Interpolate to blend from.
+    // Use either this with Interpolate or Update alone
+    void Step(float stepTime)
+    {
+        // the instances blended last frame get their matrix as of the last step back, unless their id was destroyed
+        // and given to a new instance since
+        for(size_t k = 0; k < moving.size(); k++)
+            if(!created[moving[k]])
+                matrices[moving[k]] = latestMatrices[k];
+        dropStale();
+        listMoving();
+        previous.resize(moving.size());
+        latest.resize(moving.size());
+        latestMatrices.resize(moving.size());
+        blendedLocals.resize(moving.size() - movingRoots);
+        for(size_t k = 0; k < moving.size(); k++)
+            previous[k] = stepPose(moving[k]);
+        Update(stepTime);
+        for(size_t k = 0; k < moving.size(); k++)
+        {
+            unsigned int id = moving[k];
+            latest[k] = stepPose(id);
+            latestMatrices[k] = matrices[id];
+            // the ones created since the last step have nowhere to come from
+            if(created[id])
+                previous[k] = latest[k];
+        }
+        for(size_t i = 0; i < createdIds.size(); i++)
+            created[createdIds[i]] = false;
+        createdIds.clear();
+    }
+
+    // sets the matrices of the instances moving to alpha of the way from the step before the last to the last one.
+    // Positions, scales and shears are blended linearly, orientations and rotations around a point along the
+    // shortest arc, and the world matrices composed from the blend, so a turn in a step stays rigid however big
+    void Interpolate(float alpha)
+    {
+        parallelFor(moving.size(), 4096, [this, alpha](unsigned int begin, unsigned int end) {
+            for(unsigned int k = begin; k < end; k++)
+            {
+                glm::mat4 m = blendPoses(previous[k], latest[k], alpha);
+                if(k < movingRoots)
+                    matrices[moving[k]] = m;
+                else
+                    blendedLocals[k - movingRoots] = m;
+            }
+        });
+        // those with a parent come each after its parent
+        for(size_t k = movingRoots; k < moving.size(); k++)
+            matrices[moving[k]] = matrices[parents[moving[k]]] * blendedLocals[k - movingRoots];
+    }
+
+    // the time of the last update
+    float Time() const
+    {
+        return time;
+    }
+
+    // world matrix of the instance as of the last update
+    const glm::mat4& Matrix(unsigned int id) const
+    {
+        return matrices[id];
+    }
+
+    // world matrices of every instance by id, those of destroyed ids are stale
+    const std::vector<glm::mat4>& Matrices() const
+    {
+        return matrices;
+    }
+
+    unsigned int Count() const
+    {
+        return matrices.size() - freeIds.size();
+    }
+
+    // instances whose timeline wasn't over at the last update
+    unsigned int AnimatedCount() const
+    {
+        return animatedIds.size();
+    }
+
+    // instances whose world matrix was composed again by the last update
+    unsigned int MovedCount() const
+    {
+        return movedIds.size();
+    }
+
+    // writes translate * shear * scale * orientation of the instances [first, first + count) to out[0..count),
+    // which can be any buffer, a mapped one included. These are the matrices Update computes, except for the
+    // instances rotating around a point, which Update fixes afterwards, and those with a parent, which Update
+    // multiplies by their parent's
+    void Compose(unsigned int first, unsigned int count, glm::mat4 *out) const
+    {
+#ifdef ANIMATION_SSE
+        if(Simd)
+        {
+            composeSimd(first, count, out);
+            return;
+        }
+#endif
+        for(unsigned int i = 0; i < count; i++)
+        {
+            unsigned int id = first + i;
+            out[i] = glm::mat4(shearScale(id) * basis(orientation[id]));
+            out[i][3] = glm::vec4(position[id], 1.0f);
+        }
+    }
+
+private:
+    struct Timeline {
+        // what an update reads comes first, to share a cache line
+        std::vector<Keyframe> keyframes;        // by time, the first one before anything starts
+        unsigned int cursor;                    // keyframe evaluated last
+        float cursorStart, cursorEnd;           // the times it covers, kept here to skip looking at keyframes
+        unsigned int written;                   // keyframe whose pose is in the pose arrays, if any
+        unsigned int first[ANIMATION_KIND_COUNT];   // chain of operations of each kind
+        unsigned int last[ANIMATION_KIND_COUNT];
+    };
+
+    // an instance with a parent, in the breadth first list
+    struct Link {
+        unsigned int instance;
+        unsigned int parent;
+    };
+
+    // what Interpolate blends: an instance's pose, and the rotation around a point moving it if one was running
+    struct StepPose {
+        glm::vec3 position;
+        glm::vec3 scale;
+        glm::quat orientation;
+        int shearAxis;
+        float shearFirst, shearSecond;
+        bool orbiting;
+        glm::dualquat orbit;
+    };
+
+    // an instance rotating around a point this update
+    struct Special {
+        unsigned int instance;
+        glm::dualquat orbit;
+    };
+
+    float time;
+    std::vector<Timeline> timelines;
+    // pose of each instance as of the last update
+    std::vector<glm::vec3> position;
+    std::vector<glm::vec3> scale;
+    std::vector<glm::quat> orientation;     // the pose's, times the running axis rotation
+    std::vector<int> shearAxis;
+    std::vector<float> shearFirst;
+    std::vector<float> shearSecond;
+    std::vector<unsigned char> orbiting;    // whether a rotation around a point moved the instance, by orbits
+    std::vector<glm::dualquat> orbits;
+    std::vector<bool> alive;
+    std::vector<bool> animated;             // in animatedIds
+    std::vector<glm::mat4> matrices;        // world matrices
+    std::vector<unsigned int> freeIds;
+    // the hierarchy: the parent of each instance, the matrix of its own pose if it has one, and the instances with
+    // a parent breadth first
+    std::vector<unsigned int> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<Link> links;
+    bool hierarchyChanged;                  // links is to be built again
+    std::vector<unsigned int> reparented;   // since the last update
+    std::vector<unsigned char> worldChanged;    // marks while listing or propagating, cleared after
+    std::vector<unsigned int> animatedIds;  // instances evaluated on update
+    bool staleAnimated;                     // animatedIds may list ids destroyed and created again
+    std::vector<unsigned char> done;        // per animatedIds entry, whether its timeline is over
+    std::vector<unsigned char> moved;       // per animatedIds entry, whether its matrix is to be composed
+    std::vector<unsigned int> movedIds;     // instances composed by the last update
+    std::vector<Special> specials;
+    std::mutex specialsMutex;
+    // for Step and Interpolate: the instances that moved in the last step, those without a parent first and then
+    // those with one breadth first, with their poses before and after it
+    std::vector<unsigned int> moving;
+    unsigned int movingRoots;
+    std::vector<StepPose> previous;
+    std::vector<StepPose> latest;
+    std::vector<glm::mat4> latestMatrices;
+    std::vector<glm::mat4> blendedLocals;   // matrices of the poses blended of those with a parent
+    std::vector<bool> created;              // since the last step, in createdIds
+    std::vector<unsigned int> createdIds;
+
+    OperationPool<SplineOp> splineOps;
+    // the splines followed, with how many operations (and callers of AddSpline) hold each one
+    std::vector<Spline> splines;
+    std::vector<unsigned int> splineReferences;
+    std::vector<unsigned int> freeSplines;
+    OperationPool<BezierOp> beziers;
+    OperationPool<TranslationOp> translations;
+    OperationPool<ShearOp> shears;
+    OperationPool<ScaleOp> scales;
+    OperationPool<AxisRotationOp> rotations;
+    OperationPool<RoundPointOp> roundPoints;
+
+    OperationTimes& times(int kind)
+    {
+        switch(kind)
+        {
+        case ANIMATION_SPLINE:      return splineOps;
+        case ANIMATION_BEZIER:      return beziers;
+        case ANIMATION_TRANSLATION: return translations;
+        case ANIMATION_SHEAR:       return shears;
+        case ANIMATION_SCALE:       return scales;
+        case ANIMATION_ROTATION:    return rotations;
+        default:                    return roundPoints;
+        }
+    }
+
+    // the operation of the copied chain at the same place as operation is in the source chain
+    unsigned int copyOf(int kind, unsigned int sourceFirst, unsigned int copyFirst, unsigned int operation)
+    {
+        OperationTimes &t = times(kind);
+        for(unsigned int i = sourceFirst, c = copyFirst; i != ANIMATION_NONE; i = t.next[i], c = t.next[c])
+            if(i == operation)
+                return c;
+        return ANIMATION_NONE;
+    }
+
+    void setAnimated(unsigned int id)
+    {
+        if(!animated[id])
+        {
+            animated[id] = true;
+            animatedIds.push_back(id);
+        }
+    }
+
+    // lists the instances with a parent, breadth first from those without one, after grouping them by parent
+    void flatten()
+    {
+        unsigned int count = parents.size();
+        std::vector<unsigned int> start(count + 1, 0);
+        for(unsigned int id = 0; id < count; id++)
+            if(parents[id] != ANIMATION_NONE)
+                start[parents[id] + 1]++;
+        for(unsigned int id = 0; id < count; id++)
+            start[id + 1] += start[id];
+        std::vector<unsigned int> children(start[count]);
+        std::vector<unsigned int> filled(start.begin(), start.end() - 1);
+        for(unsigned int id = 0; id < count; id++)
+            if(parents[id] != ANIMATION_NONE)
+                children[filled[parents[id]]++] = id;
+
+        links.clear();
+        for(unsigned int id = 0; id < count; id++)
+            if(parents[id] == ANIMATION_NONE)
+                for(unsigned int c = start[id]; c < start[id + 1]; c++)
+                    links.push_back(Link{children[c], id});
+        for(size_t i = 0; i < links.size(); i++)
+        {
+            unsigned int id = links[i].instance;
+            for(unsigned int c = start[id]; c < start[id + 1]; c++)
+                links.push_back(Link{children[c], id});
+        }
+        hierarchyChanged = false;
+    }
+
+    // world matrix = parent's world matrix * local one, down the list for those whose local or parent's changed
+    void propagate()
+    {
+        if(hierarchyChanged)
+            flatten();
+        for(size_t i = 0; i < movedIds.size(); i++)
+            worldChanged[movedIds[i]] = true;
+        for(size_t i = 0; i < links.size(); i++)
+        {
+            unsigned int id = links[i].instance;
+            if(worldChanged[links[i].parent] && !worldChanged[id])
+            {
+                worldChanged[id] = true;
+                movedIds.push_back(id);
+            }
+            if(worldChanged[id])
+                matrices[id] = matrices[links[i].parent] * locals[id];
+        }
+        for(size_t i = 0; i < movedIds.size(); i++)
+            worldChanged[movedIds[i]] = false;
+    }
+
+    // drops the entries of animatedIds left by destroyed instances whose id was taken again, keeping one entry for
+    // those animated again since
+    void dropStale()
+    {
+        if(!staleAnimated)
+            return;
+        unsigned int kept = 0;
+        for(unsigned int i = 0; i < animatedIds.size(); i++)
+        {
+            unsigned int id = animatedIds[i];
+            if(animated[id] && !worldChanged[id])
+            {
+                worldChanged[id] = true;
+                animatedIds[kept++] = id;
+            }
+        }
+        animatedIds.resize(kept);
+        for(unsigned int i = 0; i < kept; i++)
+            worldChanged[animatedIds[i]] = false;
+        staleAnimated = false;
+    }
+
+    // lists in moving the instances a step can move: those evaluated, those given or taken a parent, and the
+    // descendants of any of them. Subtrees with nothing animated in them are left out
+    void listMoving()
+    {
+        if(hierarchyChanged)
+            flatten();
+        moving.clear();
+        for(size_t i = 0; i < animatedIds.size() + reparented.size(); i++)
+        {
+            unsigned int id = i < animatedIds.size() ? animatedIds[i] : reparented[i - animatedIds.size()];
+            if(!worldChanged[id])
+            {
+                worldChanged[id] = true;
+                if(parents[id] == ANIMATION_NONE)
+                    moving.push_back(id);
+            }
+        }
+        movingRoots = moving.size();
+        for(size_t i = 0; i < links.size(); i++)
+        {
+            unsigned int id = links[i].instance;
+            if(worldChanged[links[i].parent])
+                worldChanged[id] = true;
+            if(worldChanged[id])
+                moving.push_back(id);
+        }
+        for(size_t k = 0; k < moving.size(); k++)
+            worldChanged[moving[k]] = false;
+    }
+
+    StepPose stepPose(unsigned int id) const
+    {
+        StepPose pose;
+        pose.position = position[id];
+        pose.scale = scale[id];
+        pose.orientation = orientation[id];
+        pose.shearAxis = shearAxis[id];
+        pose.shearFirst = shearFirst[id];
+        pose.shearSecond = shearSecond[id];
+        pose.orbiting = orbiting[id] != 0;
+        pose.orbit = orbits[id];
+        return pose;
+    }
+
+    // the matrix of the pose alpha of the way from a to b. A rotation around a point starting or ending in between
+    // has nothing to blend with, nor a shear changing axis, so the two matrices are blended instead
+    static glm::mat4 blendPoses(const StepPose &a, const StepPose &b, float alpha)
+    {
+        if(a.orbiting != b.orbiting || a.shearAxis != b.shearAxis)
+        {
+            glm::mat4 from = composePose(a);
+            return from + (composePose(b) - from) * alpha;
+        }
+        StepPose pose;
+        pose.position = a.position + (b.position - a.position) * alpha;
+        pose.scale = a.scale + (b.scale - a.scale) * alpha;
+        pose.orientation = glm::normalize(glm::slerp(a.orientation, b.orientation, alpha));
+        pose.shearAxis = b.shearAxis;
+        pose.shearFirst = a.shearFirst + (b.shearFirst - a.shearFirst) * alpha;
+        pose.shearSecond = a.shearSecond + (b.shearSecond - a.shearSecond) * alpha;
+        pose.orbiting = b.orbiting;
+        if(b.orbiting)
+        {
+            // the nearer of the two dual quaternions giving b's motion, blended linearly and normalized
+            glm::dualquat to = b.orbit;
+            if(glm::dot(a.orbit.real, to.real) < 0.0f)
+                to = glm::dualquat(-to.real, -to.dual);
+            pose.orbit = glm::normalize(glm::lerp(a.orbit, to, alpha));
+        }
+        return composePose(pose);
+    }
+
+    // the matrix compose writes for a pose
+    static glm::mat4 composePose(const StepPose &pose)
+    {
+        glm::mat3 m = shearScale(pose.shearAxis, pose.shearFirst, pose.shearSecond, pose.scale);
+        glm::mat4 out;
+        if(pose.orbiting)
+        {
+            out = glm::mat4(glm::mat3_cast(pose.orbit.real) * m);
+            out[3] = glm::vec4(pose.orbit * pose.position, 1.0f);
+            return out;
+        }
+        out = glm::mat4(m * basis(pose.orientation));
+        out[3] = glm::vec4(pose.position, 1.0f);
+        return out;
+    }
+
+    // calls job(begin, end) over [0, count), split across the workers if there are any
+    template<typename Job>
+    void parallelFor(unsigned int count, unsigned int minChunk, Job job)
+    {
+        if(Workers)
+            Workers->ParallelFor(count, minChunk, job);
+        else if(count > 0)
+            job(0, count);
+    }
+
+    template<typename Op>
+    void queue(int kind, OperationPool<Op> &pool, unsigned int id, const Op &op, float duration)
+    {
+        Timeline &timeline = timelines[id];
+        float start = time;
+        if(timeline.last[kind] != ANIMATION_NONE)
+            start = std::max(start, pool.end[timeline.last[kind]]);
+        unsigned int index = pool.Add(op, start, start + duration);
+        if(timeline.last[kind] == ANIMATION_NONE)
+            timeline.first[kind] = index;
+        else
+            pool.next[timeline.last[kind]] = index;
+        timeline.last[kind] = index;
+        compile(id, start);
+        setAnimated(id);
+    }
+
+    // Rebuilds the instance's keyframes from time from on, those before can't have changed. Walks the events (an
+    // operation starting or ending) in time order, applying every kind in turn at each one
+    void compile(unsigned int id, float from)
+    {
+        Timeline &timeline = timelines[id];
+        std::vector<Keyframe> &keyframes = timeline.keyframes;
+        while(keyframes.size() > 1 && keyframes.back().time >= from)
+            keyframes.pop_back();
+        timeline.written = ANIMATION_NONE;
+
+        Keyframe keyframe = keyframes.back();
+        // operations queued after the last keyframe: the first one of each kind that isn't done by then
+        for(int kind = 0; kind < ANIMATION_KIND_COUNT; kind++)
+        {
+            if(keyframe.current[kind] != ANIMATION_NONE)
+                continue;
+            OperationTimes &t = times(kind);
+            unsigned int i = timeline.first[kind];
+            while(i != ANIMATION_NONE && t.end[i] <= keyframe.time)
+                i = t.next[i];
+            keyframe.current[kind] = i;
+        }
+
+        for(;;)
+        {
+            float next = FLT_MAX;
+            bool any = false;
+            for(int kind = 0; kind < ANIMATION_KIND_COUNT; kind++)
+            {
+                unsigned int i = keyframe.current[kind];
+                if(i == ANIMATION_NONE)
+                    continue;
+                OperationTimes &t = times(kind);
+                next = std::min(next, t.start[i] > keyframe.time ? t.start[i] : t.end[i]);
+                any = true;
+            }
+            if(!any)
+                break;
+            float previous = keyframe.time;
+            keyframe.time = next;
+            // where a curve still running puts the position, which a translation that ends gives back to it
+            glm::vec3 curve;
+            bool curving = false;
+            for(int kind = 0; kind < ANIMATION_KIND_COUNT; kind++)
+            {
+                unsigned int i = step(kind, keyframe.current[kind], previous, next, keyframe.pose, curving ? &curve : nullptr);
+                keyframe.current[kind] = i;
+                if(kind <= ANIMATION_BEZIER && i != ANIMATION_NONE && times(kind).start[i] <= next)
+                {
+                    curve = keyframe.pose.position;
+                    curving = true;
+                }
+            }
+            keyframes.push_back(keyframe);
+        }
+        moveCursor(timeline, std::min(timeline.cursor, (unsigned int)keyframes.size() - 1));
+    }
+
+    // brings the operations of a kind from time previous to now, returning the first one not done by then. curve is
+    // the position of a curve running at now, if any
+    unsigned int step(int kind, unsigned int i, float previous, float now, AnimationPose &pose, const glm::vec3 *curve)
+    {
+        OperationTimes &t = times(kind);
+        while(i != ANIMATION_NONE && t.start[i] <= now)
+        {
+            if(t.start[i] > previous)
+                begin(kind, i, pose);
+            if(t.end[i] <= now)
+            {
+                finish(kind, i, pose);
+                // the curve moves the model again right after, so the translation queued next starts from it
+                if(kind == ANIMATION_TRANSLATION && curve)
+                    pose.position = *curve;
+                i = t.next[i];
+                continue;
+            }
+            glm::quat spin;
+            glm::dualquat orbit;
+            apply(kind, i, t.Progress(i, now), pose, spin, orbit);
+            break;
+        }
+        return i;
+    }
+
+    // what an operation takes from the pose when it starts
+    void begin(int kind, unsigned int i, AnimationPose &pose)
+    {
+        switch(kind)
+        {
+        case ANIMATION_TRANSLATION:
+            translations.from[i] = pose.position;
+            break;
+        case ANIMATION_SHEAR:
+            pose.shearAxis = shears.op[i].axis;
+            pose.shearFirst = pose.shearSecond = 0.0f;
+            break;
+        case ANIMATION_SCALE:
+            scales.from[i] = pose.scale;
+            break;
+        case ANIMATION_ROUND_POINT:
+        {
+            // turns towards the point, with up across the old and new front. When they're (nearly) parallel up is
+            // kept, turning half a turn around it if the point is behind
+            const glm::vec3 &point = roundPoints.op[i].point;
+            glm::vec3 up = pose.orientation * glm::vec3(0.0f, 1.0f, 0.0f);
+            glm::vec3 front = pose.orientation * glm::vec3(0.0f, 0.0f, 1.0f);
+            glm::vec3 newFront = point != pose.position ? glm::normalize(point - pose.position) : front;
+            glm::vec3 across = glm::cross(front, newFront);
+            if(glm::dot(across, across) > 1e-12f)
+            {
+                up = glm::normalize(across);
+                if(up.y <= 0.0)
+                    up *= -1;
+                pose.orientation = facing(up, newFront);
+            }
+            else if(glm::dot(front, newFront) < 0.0f)
+                pose.orientation = glm::normalize(glm::angleAxis(glm::pi<float>(), up) * pose.orientation);
+            break;
+        }
+        default:
+            break;
+        }
+    }
+
+    // a running operation at progress percentage (less than 1). The rotations don't change the pose until they're
+    // done: spin receives the axis rotation and orbit the rotation around a point
+    void apply(int kind, unsigned int i, float percentage, AnimationPose &pose, glm::quat &spin, glm::dualquat &orbit)
+    {
+        switch(kind)
+        {
+        case ANIMATION_SPLINE:
+            pose.position = splines[splineOps.op[i].spline].Point(percentage);
+            break;
+        case ANIMATION_BEZIER:
+            pose.position = BezierOpPoint(beziers.op[i], percentage);
+            break;
+        case ANIMATION_TRANSLATION:
+            pose.position = translations.from[i] + percentage * (translations.op[i].target - translations.from[i]);
+            break;
+        case ANIMATION_SHEAR:
+            pose.shearFirst = percentage * shears.op[i].firstValue;
+            pose.shearSecond = percentage * shears.op[i].secondValue;
+            break;
+        case ANIMATION_SCALE:
+            pose.scale = scales.from[i] + percentage * (scales.op[i].target - scales.from[i]);
+            break;
+        case ANIMATION_ROTATION:
+            // the slerp from no rotation to the whole one, which unlike a slerp between the two ends keeps turning
+            // past half a turn
+            spin = glm::angleAxis(rotations.op[i].angle * percentage, rotations.op[i].axis);
+            break;
+        case ANIMATION_ROUND_POINT:
+            orbit = roundPointMotion(roundPoints.op[i], percentage * roundPoints.op[i].angle, pose.orientation);
+            break;
+        }
+    }
+
+    // the pose an operation leaves once done
+    void finish(int kind, unsigned int i, AnimationPose &pose)
+    {
+        switch(kind)
+        {
+        case ANIMATION_SPLINE:
+            pose.position = splines[splineOps.op[i].spline].End();
+            break;
+        case ANIMATION_BEZIER:
+            pose.position = beziers.op[i].end;
+            break;
+        case ANIMATION_TRANSLATION:
+            pose.position = translations.op[i].target;
+            break;
+        case ANIMATION_SHEAR:
+            pose.shearFirst = shears.op[i].firstValue;
+            pose.shearSecond = shears.op[i].secondValue;
+            break;
+        case ANIMATION_SCALE:
+            pose.scale = scales.op[i].target;
+            break;
+        case ANIMATION_ROTATION:
+        {
+            // the position and orientation are turned the other way round from the running rotation, as the row
+            // vector products this replaced did
+            glm::quat rotate = glm::conjugate(glm::angleAxis(rotations.op[i].angle, rotations.op[i].axis));
+            pose.position = rotate * pose.position;
+            pose.orientation = glm::normalize(rotate * pose.orientation);
+            break;
+        }
+        case ANIMATION_ROUND_POINT:
+        {
+            // turned the other way round as well, and around the origin rather than the point, as the row vector
+            // product this replaced did. The front is turned back to the point
+            const RoundPointOp &r = roundPoints.op[i];
+            glm::vec3 up = pose.orientation * glm::vec3(0.0f, 1.0f, 0.0f);
+            pose.position = glm::conjugate(glm::angleAxis(r.angle, up)) * pose.position;
+            pose.orientation = facing(up, glm::normalize(r.point - pose.position));
+            break;
+        }
+        }
+    }
+
+    // the rotation of angle radians around the instance's up, through the point: x -> q * (x - point) + point
+    static glm::dualquat roundPointMotion(const RoundPointOp &r, float angle, const glm::quat &orientation)
+    {
+        glm::quat q = glm::angleAxis(angle, orientation * glm::vec3(0.0f, 1.0f, 0.0f));
+        return glm::dualquat(q, r.point - q * r.point);
+    }
+
+    // the orientation turning +z to front, a unit vector, and +y to up as near as it can at right angles to front
+    static glm::quat facing(const glm::vec3 &up, const glm::vec3 &front)
+    {
+        glm::vec3 square = glm::normalize(up - glm::dot(up, front) * front);
+        return glm::normalize(glm::quat_cast(glm::mat3(glm::cross(square, front), square, front)));
+    }
+
+    // the orientation as a matrix whose columns are right, up and front. Right is front x up, as it always was,
+    // which mirrors x
+    static glm::mat3 basis(const glm::quat &orientation)
+    {
+        glm::mat3 m = glm::mat3_cast(orientation);
+        m[0] = -m[0];
+        return m;
+    }
+
+    // the last keyframe at or before t: the one used last or the next when playing forward, else a binary search
+    unsigned int findKeyframe(Timeline &timeline, float t) const
+    {
+        if(t >= timeline.cursorStart && t < timeline.cursorEnd)
+            return timeline.cursor;
+        const std::vector<Keyframe> &keyframes = timeline.keyframes;
+        unsigned int count = keyframes.size();
+        // mostly time went on to the next keyframe
+        unsigned int next = timeline.cursor + 1;
+        if(next < count && keyframes[next].time <= t && (next + 1 == count || keyframes[next + 1].time > t))
+            return moveCursor(timeline, next);
+        unsigned int low = 0, high = count;     // keyframes[low].time <= t < keyframes[high].time
+        while(high - low > 1)
+        {
+            unsigned int middle = (low + high) / 2;
+            if(keyframes[middle].time <= t)
+                low = middle;
+            else
+                high = middle;
+        }
+        return moveCursor(timeline, low);
+    }
+
+    static unsigned int moveCursor(Timeline &timeline, unsigned int k)
+    {
+        const std::vector<Keyframe> &keyframes = timeline.keyframes;
+        timeline.cursor = k;
+        timeline.cursorStart = keyframes[k].time;
+        timeline.cursorEnd = k + 1 < keyframes.size() ? keyframes[k + 1].time : FLT_MAX;
+        return k;
+    }
+
+    // Writes the instance's pose at time t to the pose arrays. When a rotation around a point is running then,
+    // aroundPoint is set and orbit receives it. poseChanged tells whether anything written differs from what was
+    // there. Returns whether the timeline is over by t
+    bool sample(unsigned int id, float t, glm::dualquat &orbit, bool &aroundPoint, bool &poseChanged)
+    {
+        Timeline &timeline = timelines[id];
+        unsigned int k = findKeyframe(timeline, t);
+        const Keyframe &keyframe = timeline.keyframes[k];
+        AnimationPose pose = keyframe.pose;
+        poseChanged = timeline.written != k;
+        // the keyframe's pose is written once, from then on only what the running operations change
+        if(timeline.written != k)
+        {
+            position[id] = pose.position;
+            scale[id] = pose.scale;
+            shearAxis[id] = pose.shearAxis;
+            shearFirst[id] = pose.shearFirst;
+            shearSecond[id] = pose.shearSecond;
+            orientation[id] = pose.orientation;
+            timeline.written = k;
+        }
+        glm::quat spin;
+        unsigned int running = 0;
+        for(int kind = 0; kind < ANIMATION_KIND_COUNT; kind++)
+        {
+            unsigned int i = keyframe.current[kind];
+            if(i == ANIMATION_NONE)
+                continue;
+            OperationTimes &ts = times(kind);
+            if(ts.start[i] <= t)
+            {
+                apply(kind, i, ts.Progress(i, t), pose, spin, orbit);
+                running |= 1 << kind;
+            }
+        }
+        if(running & (1 << ANIMATION_SPLINE | 1 << ANIMATION_BEZIER | 1 << ANIMATION_TRANSLATION))
+            position[id] = pose.position;
+        if(running & 1 << ANIMATION_SCALE)
+            scale[id] = pose.scale;
+        if(running & 1 << ANIMATION_SHEAR)
+        {
+            shearFirst[id] = pose.shearFirst;
+            shearSecond[id] = pose.shearSecond;
+        }
+        if(running & 1 << ANIMATION_ROTATION)
+            orientation[id] = spin * pose.orientation;
+        aroundPoint = (running & 1 << ANIMATION_ROUND_POINT) != 0;
+        poseChanged = poseChanged || running != 0;
+        return t >= timeline.keyframes.back().time;
+    }
+
+    // shear * scale: column j is scale j times e_j, plus the shear of that column on the sheared axis' row
+    glm::mat3 shearScale(unsigned int id) const
+    {
+        return shearScale(shearAxis[id], shearFirst[id], shearSecond[id], scale[id]);
+    }
+
+    static glm::mat3 shearScale(int axis, float first, float second, const glm::vec3 &scale)
+    {
+        glm::mat3 m(1.0f);
+        m[(axis + 1) % 3][axis] = first;
+        m[(axis + 2) % 3][axis] = second;
+        m[0] *= scale.x;
+        m[1] *= scale.y;
+        m[2] *= scale.z;
+        return m;
+    }
+
+    // where the matrix of the instance's pose goes: its world matrix, or with a parent its local one
+    glm::mat4& target(unsigned int id)
+    {
+        return parents[id] == ANIMATION_NONE ? matrices[id] : locals[id];
+    }
+
+    // composes the matrices of the instances listed
+    void composeIds(const unsigned int *ids, unsigned int count)
+    {
+#ifdef ANIMATION_SSE
+        if(Simd)
+        {
+            for(unsigned int i = 0; i < count; i++)
+                composeSimd(ids[i], 1, &target(ids[i]));
+            return;
+        }
+#endif
+        for(unsigned int i = 0; i < count; i++)
+            compose(ids[i], nullptr);
+    }
+
+    // translate * shear * scale, then either times the orientation or moved by a rotation around a point
+    void compose(unsigned int id, const glm::dualquat *orbit)
+    {
+        glm::mat4 &out = target(id);
+        if(orbit)
+        {
+            out = glm::mat4(glm::mat3_cast(orbit->real) * shearScale(id));
+            out[3] = glm::vec4(*orbit * position[id], 1.0f);
+            return;
+        }
+        out = glm::mat4(shearScale(id) * basis(orientation[id]));
+        out[3] = glm::vec4(position[id], 1.0f);
+    }
+
+#ifdef ANIMATION_SSE
+    // Compose four floats at a time: each column of the result is the shear * scale columns weighted by a column of
+    // the orientation, the same products and sums the scalar path does, in the same order
+    void composeSimd(unsigned int first, unsigned int count, glm::mat4 *out) const
+    {
+        for(unsigned int i = 0; i < count; i++)
+        {
+            unsigned int id = first + i;
+            const glm::vec3 &s = scale[id];
+            int axis = shearAxis[id];
+            float m[3][4] = {{s.x, 0.0f, 0.0f, 0.0f}, {0.0f, s.y, 0.0f, 0.0f}, {0.0f, 0.0f, s.z, 0.0f}};
+            m[(axis + 1) % 3][axis] = shearFirst[id] * s[(axis + 1) % 3];
+            m[(axis + 2) % 3][axis] = shearSecond[id] * s[(axis + 2) % 3];
+            __m128 m0 = _mm_loadu_ps(m[0]);
+            __m128 m1 = _mm_loadu_ps(m[1]);
+            __m128 m2 = _mm_loadu_ps(m[2]);
+
+            glm::mat3 r = basis(orientation[id]);
+            float *o = &out[i][0][0];
+            for(int j = 0; j < 3; j++)
+            {
+                __m128 column = _mm_add_ps(_mm_add_ps(_mm_mul_ps(m0, _mm_set1_ps(r[j][0])), _mm_mul_ps(m1, _mm_set1_ps(r[j][1]))), _mm_mul_ps(m2, _mm_set1_ps(r[j][2])));
+                _mm_storeu_ps(o + 4 * j, column);
+            }
+            const glm::vec3 &p = position[id];
+            _mm_storeu_ps(o + 12, _mm_set_ps(1.0f, p.z, p.y, p.x));
+        }
+    }
+#endif
+};
+
+// The animation system every Model is animated by
+inline AnimationSystem& Animations()
+{
+    static AnimationSystem system;
+    return system;
+}
+#endif
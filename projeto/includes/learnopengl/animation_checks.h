@@ -0,0 +1,126 @@
+#ifndef ANIMATION_CHECKS_H
+#define ANIMATION_CHECKS_H
+
+#include <learnopengl/animation.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+// Checks of what the animation system must get right, run by the program's --check option. Each prints what went
+// wrong and returns whether everything held. They need no OpenGL context
+
+// largest difference between the entries of two matrices
+inline float AnimationMatrixDifference(const glm::mat4 &a, const glm::mat4 &b)
+{
+    float difference = 0.0f;
+    for(int c = 0; c < 4; c++)
+        for(int r = 0; r < 4; r++)
+            difference = std::max(difference, std::fabs(a[c][r] - b[c][r]));
+    return difference;
+}
+
+// an instance destroyed while moving, its id taken by a new one before the next step: the new one must be at the
+// origin, not where the destroyed one was
+inline bool CheckDestroyedIdReuse()
+{
+    AnimationSystem steps;
+    unsigned int mover = steps.Create();
+    TranslationOp away = {glm::vec3(10.0f)};
+    steps.Translate(mover, away, 1.0f);
+    steps.Step(0.0f);
+    steps.Step(0.5f);
+    steps.Interpolate(0.5f);
+    steps.Destroy(mover);
+    unsigned int reused = steps.Create();
+    steps.Step(0.5f + 1.0f / 60.0f);
+    steps.Interpolate(0.5f);
+    if(steps.Matrix(reused)[3] != glm::vec4(0.0f, 0.0f, 0.0f, 1.0f))
+    {
+        printf("destroy, create and step: the new instance has the destroyed one's pose\n");
+        return false;
+    }
+    return true;
+}
+
+// a spin of 72 degrees a step, and its child, blended halfway between steps must be where an update at that time
+// puts them, not shrunk by blending the matrices
+inline bool CheckInterpolation()
+{
+    AnimationSystem systems[2];
+    unsigned int spinner = 0, child = 0;
+    for(int s = 0; s < 2; s++)
+    {
+        spinner = systems[s].Create();
+        TranslationOp place = {glm::vec3(3.0f, 0.0f, 0.0f)};
+        systems[s].Translate(spinner, place, 0);
+        AxisRotationOp spin = {glm::radians(720.0f), glm::vec3(0.0f, 1.0f, 0.0f)};
+        systems[s].Rotate(spinner, spin, 1.0f);
+        child = systems[s].Create();
+        TranslationOp offset = {glm::vec3(1.0f, 0.0f, 0.0f)};
+        systems[s].Translate(child, offset, 0);
+        systems[s].SetParent(child, spinner);
+    }
+    AnimationSystem &stepped = systems[0], &updated = systems[1];
+    stepped.Step(0.0f);
+    stepped.Step(0.1f);
+    stepped.Step(0.2f);
+    stepped.Interpolate(0.5f);
+    updated.Update(0.15f);
+    float difference = std::max(AnimationMatrixDifference(stepped.Matrix(spinner), updated.Matrix(spinner)),
+                                AnimationMatrixDifference(stepped.Matrix(child), updated.Matrix(child)));
+    if(difference > 1e-4f)
+    {
+        printf("interpolation: halfway between steps off by %g from an update at that time\n", difference);
+        return false;
+    }
+    return true;
+}
+
+// queues moves and turns overlapping each other, for many keyframes
+inline void QueueSeekTimeline(AnimationSystem &system, unsigned int id)
+{
+    for(int m = 0; m < 20; m++)
+    {
+        TranslationOp move = {glm::vec3((float)(m % 7), (float)(m % 3), (float)m)};
+        system.Translate(id, move, 0.1f);
+        AxisRotationOp turn = {0.5f, glm::vec3(0.0f, 1.0f, 0.0f)};
+        system.Rotate(id, turn, 0.15f);
+    }
+}
+
+// updates jumping back and forth along a timeline must give what updating straight to each time gives
+inline bool CheckKeyframeSeek()
+{
+    AnimationSystem system;
+    unsigned int id = system.Create();
+    QueueSeekTimeline(system, id);
+    const float times[] = {0.05f, 1.7f, 0.3f, 2.9f, 0.0f, 1.0f, 0.95f, 5.0f, 0.45f};
+    for(unsigned int i = 0; i < sizeof(times) / sizeof(times[0]); i++)
+    {
+        system.Update(times[i]);
+        AnimationSystem fresh;
+        unsigned int copy = fresh.Create();
+        QueueSeekTimeline(fresh, copy);
+        fresh.Update(times[i]);
+        float difference = AnimationMatrixDifference(system.Matrix(id), fresh.Matrix(copy));
+        if(difference > 1e-5f)
+        {
+            printf("keyframe seek: at %g s off by %g from updating straight to it\n", times[i], difference);
+            return false;
+        }
+    }
+    return true;
+}
+
+// runs every check, returning whether all of them held
+inline bool CheckAnimation()
+{
+    bool ok = true;
+    ok = CheckDestroyedIdReuse() && ok;
+    ok = CheckInterpolation() && ok;
+    ok = CheckKeyframeSeek() && ok;
+    printf("animation checks %s\n", ok ? "passed" : "FAILED");
+    return ok;
+}
+#endif
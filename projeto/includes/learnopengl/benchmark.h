@@ -0,0 +1,465 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <learnopengl/animation.h>
+#include <learnopengl/filesystem.h>
+#include <learnopengl/importer.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/worker_pool.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Small timing helpers used to measure the renderer and the loaders. They need a current OpenGL context
+// unless they say otherwise
+
+// the models shipped in resources/objects
+const char* const BENCHMARK_MODELS[] = {
+    "resources/objects/planet/planet.obj",
+    "resources/objects/rock/rock.obj",
+    "resources/objects/cyborg/cyborg.obj",
+    "resources/objects/nanosuit/nanosuit.obj",
+    "resources/objects/cube/cube.obj"
+};
+const int BENCHMARK_MODEL_COUNT = sizeof(BENCHMARK_MODELS) / sizeof(BENCHMARK_MODELS[0]);
+
+// Returns the time in milliseconds since some arbitrary point
+inline double BenchmarkNow()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Imports every bundled model with every import profile and prints how long each import took. Only assimp's
+// read and post-processing are timed, no textures are decoded and nothing is uploaded, so needs no OpenGL context
+inline void BenchmarkImportProfiles(int repetitions = 3)
+{
+    printf("Import profiles (best of %d imports)\n", repetitions);
+    Assimp::Importer &importer = GetThreadImporter();
+    for(int m = 0; m < BENCHMARK_MODEL_COUNT; m++)
+    {
+        for(int p = 0; p < IMPORT_PROFILE_COUNT; p++)
+        {
+            Import_Profile profile = (Import_Profile)p;
+            double best = 0.0;
+            size_t vertexCount = 0;
+            for(int r = 0; r < repetitions; r++)
+            {
+                double start = BenchmarkNow();
+                const aiScene *scene = ImportScene(FileSystem::getPath(BENCHMARK_MODELS[m]), profile);
+                double elapsed = BenchmarkNow() - start;
+                if(r == 0 || elapsed < best)
+                    best = elapsed;
+                vertexCount = 0;
+                for(unsigned int i = 0; scene && i < scene->mNumMeshes; i++)
+                    vertexCount += scene->mMeshes[i]->mNumVertices;
+                importer.FreeScene();
+            }
+            printf("  %-40s %-15s %9.2f ms %8zu vertices\n", BENCHMARK_MODELS[m], GetImportSettings(profile).name, best, vertexCount);
+        }
+    }
+}
+
+// Measures what setting a uniform costs: looked up by the driver every time (how Shader used to work),
+// looked up in the shader's table, set through a handle, and set through a handle to a value it already has.
+// The camera lives in a uniform block, so the sampler is what's left to measure on the bundled shader
+inline void BenchmarkUniforms(Shader &shader, const char *name = "texture_diffuse1", int iterations = 100000)
+{
+    shader.use();
+    Uniform handle = shader.getUniform(name);
+    if(!handle.isValid())
+    {
+        printf("Uniform %s is not used by the shader\n", name);
+        return;
+    }
+    std::string uniformName(name);
+    // consecutive iterations upload different values, so nothing but the last case gets elided. The first case
+    // goes behind the handle's back, the ones after it bring the handle and the program to agree again
+    double start, driverLookup, tableLookup, handleSet, elidedSet;
+
+    glFinish();
+    start = BenchmarkNow();
+    for(int i = 0; i < iterations; i++)
+        glUniform1i(glGetUniformLocation(shader.ID, uniformName.c_str()), i & 1);
+    glFinish();
+    driverLookup = BenchmarkNow() - start;
+
+    start = BenchmarkNow();
+    for(int i = 0; i < iterations; i++)
+        shader.setInt(uniformName, i & 1);
+    glFinish();
+    tableLookup = BenchmarkNow() - start;
+
+    start = BenchmarkNow();
+    for(int i = 0; i < iterations; i++)
+        handle.set(i & 1);
+    glFinish();
+    handleSet = BenchmarkNow() - start;
+
+    start = BenchmarkNow();
+    for(int i = 0; i < iterations; i++)
+        handle.set(0);
+    glFinish();
+    elidedSet = BenchmarkNow() - start;
+
+    printf("Uniform %s, %d sets\n", name, iterations);
+    printf("  glGetUniformLocation + glUniform %8.1f ns/set\n", driverLookup * 1e6 / iterations);
+    printf("  Shader::setInt by name           %8.1f ns/set\n", tableLookup * 1e6 / iterations);
+    printf("  Uniform handle                   %8.1f ns/set\n", handleSet * 1e6 / iterations);
+    printf("  Uniform handle, same value       %8.1f ns/set\n", elidedSet * 1e6 / iterations);
+}
+
+// Fills system with count instances laid out on a grid: a quarter idle, a quarter translating, a quarter rotating
+// around an axis and a quarter moving along a Bézier curve, none finishing within 1000 seconds
+inline void BenchmarkAnimationScene(AnimationSystem &system, unsigned int count)
+{
+    for(unsigned int i = 0; i < count; i++)
+    {
+        unsigned int id = system.Create();
+        glm::vec3 position((float)(i % 100), 0.0f, (float)(i / 100));
+        TranslationOp place = {position};
+        system.Translate(id, place, 0);
+        if(i % 4 == 1)
+        {
+            TranslationOp move = {position + glm::vec3(0.0f, 10.0f, 0.0f)};
+            system.Translate(id, move, 1000);
+        }
+        else if(i % 4 == 2)
+        {
+            AxisRotationOp spin = {glm::radians(3600.0f), glm::vec3(0.0f, 1.0f, 0.0f)};
+            system.Rotate(id, spin, 1000);
+        }
+        else if(i % 4 == 3)
+        {
+            CurveOp curve = {position, position + glm::vec3(1.0f), position + glm::vec3(2.0f, 0.0f, 1.0f), position + glm::vec3(3.0f)};
+            system.Bezier(id, curve, 1000);
+        }
+    }
+    system.Update(0.0f);
+}
+
+// Times AnimationSystem::Update on count instances of the benchmark scene, then the same updates on 2, 4...
+// worker threads, up to the number of cores. Needs no OpenGL context
+inline void BenchmarkAnimationUpdate(unsigned int count = 100000, int frames = 120)
+{
+    AnimationSystem system;
+    BenchmarkAnimationScene(system, count);
+    double start = BenchmarkNow();
+    for(int frame = 1; frame <= frames; frame++)
+        system.Update(frame / 60.0f);
+    double elapsed = BenchmarkNow() - start;
+    printf("Animation of %u instances: %.3f ms per update, %.1f ns per instance\n", count, elapsed / frames, elapsed * 1e6 / frames / count);
+
+    unsigned int cores = std::max(1u, std::thread::hardware_concurrency());
+    for(unsigned int threads = 2; threads <= cores; threads *= 2)
+    {
+        WorkerPool workers(threads);
+        system.Workers = &workers;
+        double threaded = BenchmarkNow();
+        for(int frame = 1; frame <= frames; frame++)
+            system.Update(frame / 60.0f);
+        threaded = BenchmarkNow() - threaded;
+        printf("  %2u threads: %.3f ms per update, %.2fx\n", threads, threaded / frames, elapsed / threaded);
+        system.Workers = nullptr;
+    }
+}
+
+// Times composing the matrices of count instances alone, into a buffer of its own like an instance upload buffer,
+// with the scalar and the SIMD paths. Needs no OpenGL context
+inline void BenchmarkAnimationCompose(unsigned int count = 100000, int frames = 120)
+{
+    AnimationSystem system;
+    BenchmarkAnimationScene(system, count);
+    std::vector<glm::mat4> matrices(count);
+    printf("Composing %u matrices\n", count);
+    for(int simd = 0; simd < 2; simd++)
+    {
+        system.Simd = simd != 0;
+        double start = BenchmarkNow();
+        for(int frame = 0; frame < frames; frame++)
+            system.Compose(0, count, &matrices[0]);
+        double elapsed = BenchmarkNow() - start;
+        printf("  %s %8.1f M matrices/s\n", simd ? "SIMD  " : "scalar", (double)count * frames / elapsed / 1e3);
+    }
+}
+
+// Times finding the keyframe of count instances whose timelines hold a hundred moves each: playing forward a
+// frame at a time, where the keyframe is the one used last or the next, then jumping to random times, which
+// searches for it. Needs no OpenGL context
+inline void BenchmarkKeyframeSeek(unsigned int count = 10000, int frames = 120)
+{
+    const int moves = 100;
+    AnimationSystem system;
+    for(unsigned int i = 0; i < count; i++)
+    {
+        unsigned int id = system.Create();
+        for(int m = 0; m < moves; m++)
+        {
+            TranslationOp move = {glm::vec3((float)(m % 7), (float)(i % 100), (float)(m % 3))};
+            system.Translate(id, move, 0.1f);
+        }
+    }
+    float length = moves * 0.1f;
+    system.Update(0.0f);
+
+    double start = BenchmarkNow();
+    for(int frame = 1; frame <= frames; frame++)
+        system.Update(length * frame / frames);
+    double forward = BenchmarkNow() - start;
+
+    unsigned int seed = 1;
+    start = BenchmarkNow();
+    for(int frame = 1; frame <= frames; frame++)
+    {
+        seed = seed * 1664525u + 1013904223u;
+        system.Update(length * (seed >> 8) / 16777216.0f);
+    }
+    double jumping = BenchmarkNow() - start;
+    printf("Keyframes of %u instances, %d moves each\n", count, moves);
+    printf("  playing forward  %.3f ms per update\n", forward / frames);
+    printf("  random times     %.3f ms per update\n", jumping / frames);
+}
+
+// Chains rotations about random axes on one instance and prints how far its orientation strays from the same
+// rotations turning up and front in double precision (the other way round, as finished rotations turn the pose).
+// Needs no OpenGL context
+inline void BenchmarkRotationDrift(int rotations = 10000)
+{
+    AnimationSystem chain;
+    unsigned int id = chain.Create();
+    glm::dvec3 up(0.0, 1.0, 0.0), front(0.0, 0.0, 1.0);
+    unsigned int seed = 1;
+    for(int i = 0; i < rotations; i++)
+    {
+        float random[4];
+        for(int r = 0; r < 4; r++)
+        {
+            seed = seed * 1664525u + 1013904223u;
+            random[r] = (seed >> 8) / 8388608.0f - 1.0f;
+        }
+        AxisRotationOp rotation = {3.0f * random[0], glm::vec3(random[1], random[2], random[3] + 2.0f)};
+        chain.Rotate(id, rotation, 0.001f);
+        glm::dmat3 turn(glm::rotate(glm::dmat4(1.0), (double)rotation.angle, glm::dvec3(rotation.axis)));
+        up = glm::normalize(up * turn);
+        front = glm::normalize(front * turn);
+    }
+    chain.Update(2.0f * rotations * 0.001f);
+    const glm::mat4 &m = chain.Matrix(id);
+    glm::dvec3 right(m[0]), newUp(m[1]), newFront(m[2]);
+    double length = std::max(std::max(std::fabs(glm::length(right) - 1.0), std::fabs(glm::length(newUp) - 1.0)), std::fabs(glm::length(newFront) - 1.0));
+    double skew = std::max(std::max(std::fabs(glm::dot(right, newUp)), std::fabs(glm::dot(newUp, newFront))), std::fabs(glm::dot(right, newFront)));
+    double error = std::max(glm::length(newUp - up), glm::length(newFront - front));
+    printf("Drift after %d rotations: length %.2g, skew %.2g, orientation error %.2g\n", rotations, length, skew, error);
+}
+
+// Times updating a scene of count static rocks, one in a hundred moving: the idle ones shouldn't cost anything.
+// Needs no OpenGL context
+inline void BenchmarkIdleInstances(unsigned int count = 100000, int frames = 120)
+{
+    AnimationSystem rocks;
+    for(unsigned int i = 0; i < count; i++)
+    {
+        unsigned int id = rocks.Create();
+        glm::vec3 position((float)(i % 100), 0.0f, (float)(i / 100));
+        TranslationOp place = {position};
+        rocks.Translate(id, place, 0);
+        if(i % 100 == 0)
+        {
+            TranslationOp move = {position + glm::vec3(0.0f, 10.0f, 0.0f)};
+            rocks.Translate(id, move, 1000);
+        }
+    }
+    rocks.Update(0.0f);
+    double start = BenchmarkNow();
+    for(int frame = 1; frame <= frames; frame++)
+        rocks.Update(frame / 60.0f);
+    double elapsed = BenchmarkNow() - start;
+    printf("Static rocks, 1%% of %u moving: %.3f ms per update, %u matrices composed\n", count, elapsed / frames, rocks.MovedCount());
+}
+
+// Times updating a tree of count instances, eight children to an instance, spinning at the root: every world
+// matrix changes. Then spinning one of the leaves instead, which only changes that one. Needs no OpenGL context
+inline void BenchmarkHierarchy(unsigned int count = 100000, int frames = 120)
+{
+    printf("Tree of %u instances\n", count);
+    for(int leaf = 0; leaf < 2; leaf++)
+    {
+        AnimationSystem tree;
+        for(unsigned int i = 0; i < count; i++)
+        {
+            unsigned int id = tree.Create();
+            TranslationOp place = {glm::vec3(1.0f, 0.0f, 0.0f)};
+            tree.Translate(id, place, 0);
+            if(i > 0)
+                tree.SetParent(id, (i - 1) / 8);
+        }
+        AxisRotationOp spin = {glm::radians(3600.0f), glm::vec3(0.0f, 1.0f, 0.0f)};
+        tree.Rotate(leaf ? count - 1 : 0, spin, 1000);
+        tree.Update(0.0f);
+        double start = BenchmarkNow();
+        for(int frame = 1; frame <= frames; frame++)
+            tree.Update(frame / 60.0f);
+        double elapsed = BenchmarkNow() - start;
+        printf("  %s spinning: %.3f ms per update, %u matrices composed\n", leaf ? "a leaf" : "the root", elapsed / frames, tree.MovedCount());
+    }
+}
+
+// Runs every animation benchmark. Needs no OpenGL context
+inline void BenchmarkAnimation()
+{
+    BenchmarkAnimationUpdate();
+    BenchmarkAnimationCompose();
+    BenchmarkKeyframeSeek();
+    BenchmarkRotationDrift();
+    BenchmarkIdleInstances();
+    BenchmarkHierarchy();
+}
+
+// Times evaluating Bézier curves with pow (BezierPoint), as a polynomial by Horner's rule and at constant speed
+// through the arc length table, and prints how far the polynomial strays from pow and how even the speed is
+// along the curve each way. Needs no OpenGL context
+inline void BenchmarkCurves(int evaluations = 10000000)
+{
+    const int curveCount = 64;
+    std::vector<CurveOp> curves;
+    std::vector<BezierOp> linear, constant;
+    for(int i = 0; i < curveCount; i++)
+    {
+        float f = (float)i;
+        CurveOp curve = {glm::vec3(f, 0.0f, 0.0f), glm::vec3(f - 1.0f, 0.0f, 0.5f * f), glm::vec3(1.0f, 4.0f + f, -3.0f), glm::vec3(-4.0f, 0.0f, -10.0f - f)};
+        curves.push_back(curve);
+        linear.push_back(BezierOperation(curve, false));
+        constant.push_back(BezierOperation(curve, true));
+    }
+
+    const char *names[3] = {"pow", "polynomial", "constant speed"};
+    for(int method = 0; method < 3; method++)
+    {
+        glm::vec3 sum(0.0f);
+        double start = BenchmarkNow();
+        for(int i = 0; i < evaluations; i++)
+        {
+            float t = (i % 1000) / 999.0f;
+            int c = i % curveCount;
+            if(method == 0)
+                sum += BezierPoint(curves[c], t);
+            else if(method == 1)
+                sum += BezierOpPoint(linear[c], t);
+            else
+                sum += BezierOpPoint(constant[c], t);
+        }
+        double elapsed = BenchmarkNow() - start;
+        // keeps the evaluations from being optimized away
+        volatile float sink = sum.x + sum.y + sum.z;
+        (void)sink;
+        printf("Bezier, %-15s %8.1f M evaluations/s\n", names[method], evaluations / elapsed / 1e3);
+    }
+
+    float difference = 0.0f;
+    for(int c = 0; c < curveCount; c++)
+        for(int i = 0; i <= 1000; i++)
+        {
+            float t = i / 1000.0f;
+            glm::vec3 d = BezierPoint(curves[c], t) - BezierOpPoint(linear[c], t);
+            difference = std::max(difference, std::max(std::fabs(d.x), std::max(std::fabs(d.y), std::fabs(d.z))));
+        }
+    printf("  polynomial against pow: %g at most\n", difference);
+
+    // the distance covered in each of 100 equal slices of time, fastest against slowest
+    for(int method = 1; method < 3; method++)
+    {
+        float worst = 1.0f;
+        for(int c = 0; c < curveCount; c++)
+        {
+            const BezierOp &op = method == 1 ? linear[c] : constant[c];
+            float fastest = 0.0f, slowest = FLT_MAX;
+            for(int i = 0; i < 100; i++)
+            {
+                float step = glm::length(BezierOpPoint(op, (i + 1) / 100.0f) - BezierOpPoint(op, i / 100.0f));
+                fastest = std::max(fastest, step);
+                slowest = std::min(slowest, step);
+            }
+            worst = std::max(worst, fastest / std::max(slowest, 1e-6f));
+        }
+        printf("  %-15s speed varies up to %.2fx along a curve\n", names[method], worst);
+    }
+}
+
+// Imports every bundled model and prints how much index memory 16 bit indices take compared to 32 bit ones,
+// with large meshes kept whole and then split to fit 16 bits. Each mesh gets the index type Mesh would give it,
+// counted from the imported scene without building the model, so needs no OpenGL context
+inline void ReportIndexMemory()
+{
+    bool split = SplitForShortIndices();
+    Assimp::Importer &importer = GetThreadImporter();
+    for(int pass = 0; pass < 2; pass++)
+    {
+        SplitForShortIndices() = pass == 1;
+        printf("Index memory, large meshes %s\n", pass == 1 ? "split" : "kept whole");
+        size_t totalWide = 0, totalActual = 0;
+        for(int m = 0; m < BENCHMARK_MODEL_COUNT; m++)
+        {
+            const aiScene *scene = ImportScene(FileSystem::getPath(BENCHMARK_MODELS[m]), IMPORT_FULL_QUALITY);
+            unsigned int meshCount = scene ? scene->mNumMeshes : 0;
+            size_t wide = 0, actual = 0;
+            unsigned int shortMeshes = 0;
+            for(unsigned int i = 0; i < meshCount; i++)
+            {
+                const aiMesh *mesh = scene->mMeshes[i];
+                size_t indexCount = 0;
+                for(unsigned int f = 0; f < mesh->mNumFaces; f++)
+                    indexCount += mesh->mFaces[f].mNumIndices;
+                wide += indexCount * sizeof(unsigned int);
+                if(mesh->mNumVertices <= SHORT_INDEX_VERTEX_LIMIT)
+                {
+                    actual += indexCount * sizeof(unsigned short);
+                    shortMeshes++;
+                }
+                else
+                    actual += indexCount * sizeof(unsigned int);
+            }
+            importer.FreeScene();
+            printf("  %-40s %3u/%-3u meshes 16 bit %10zu bytes (%zu with 32 bit)\n", BENCHMARK_MODELS[m], shortMeshes, meshCount, actual, wide);
+            totalWide += wide;
+            totalActual += actual;
+        }
+        printf("  saved %zu of %zu bytes\n", totalWide - totalActual, totalWide);
+    }
+    SplitForShortIndices() = split;
+}
+
+// Returns the p-th percentile (0 to 100) of samples, sorting them in place; nearest rank, so it's always a sample
+inline double Percentile(std::vector<double> &samples, double p)
+{
+    if(samples.empty())
+        return 0.0;
+    std::sort(samples.begin(), samples.end());
+    size_t rank = (size_t)std::ceil(p / 100.0 * samples.size());
+    if(rank < 1)
+        rank = 1;
+    if(rank > samples.size())
+        rank = samples.size();
+    return samples[rank - 1];
+}
+
+// Saves the color buffer being drawn to as a binary PPM, which needs no image library to write
+inline bool SaveFramebufferImage(const std::string &path, int width, int height)
+{
+    std::vector<unsigned char> pixels(width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, &pixels[0]);
+    FILE *file = fopen(path.c_str(), "wb");
+    if(!file)
+        return false;
+    fprintf(file, "P6\n%d %d\n255\n", width, height);
+    // GL rows start at the bottom, PPM rows at the top
+    for(int y = height - 1; y >= 0; y--)
+        fwrite(&pixels[y * width * 3], 1, width * 3, file);
+    fclose(file);
+    return true;
+}
+#endif
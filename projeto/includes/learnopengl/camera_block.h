@@ -0,0 +1,76 @@
+#ifndef CAMERA_BLOCK_H
+#define CAMERA_BLOCK_H
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <learnopengl/camera.h>
+#include <learnopengl/shader.h>
+
+// Binding point of the camera uniform block
+const GLuint CAMERA_BLOCK_BINDING = 0;
+
+// std140 layout of the block, as declared by the shaders:
+//   layout (std140) uniform Camera { mat4 view; mat4 projection; mat4 viewProjection; vec4 cameraPosition; };
+struct CameraBlockData {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 viewProjection;
+    glm::vec4 position;
+};
+
+// A uniform buffer holding the camera matrices, shared by every program using the "Camera" block.
+// It is uploaded once per frame at most, and only when the camera or the projection parameters changed,
+// so adding programs adds no camera uploads. Create it before the shaders so they get bound to it when linked
+class CameraUniformBlock
+{
+public:
+    // the matrices last uploaded
+    CameraBlockData Data;
+
+    CameraUniformBlock() : UBO(0), cameraVersion(0), aspect(0.0f), zoom(0.0f), nearPlane(0.0f), farPlane(0.0f), valid(false)
+    {
+        SharedUniformBlocks()["Camera"] = CAMERA_BLOCK_BINDING;
+    }
+
+    // refreshes the block from the camera, returns whether anything had to be uploaded
+    bool Update(const Camera &camera, float aspect, float nearPlane, float farPlane)
+    {
+        if(!UBO)
+        {
+            glGenBuffers(1, &UBO);
+            glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+            glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlockData), NULL, GL_DYNAMIC_DRAW);
+            glBindBufferBase(GL_UNIFORM_BUFFER, CAMERA_BLOCK_BINDING, UBO);
+        }
+        bool projectionChanged = !valid || camera.Zoom != zoom || aspect != this->aspect || nearPlane != this->nearPlane || farPlane != this->farPlane;
+        if(valid && !projectionChanged && camera.Version == cameraVersion)
+            return false;
+        if(projectionChanged)
+        {
+            Data.projection = glm::perspective(glm::radians(camera.Zoom), aspect, nearPlane, farPlane);
+            zoom = camera.Zoom;
+            this->aspect = aspect;
+            this->nearPlane = nearPlane;
+            this->farPlane = farPlane;
+        }
+        Data.view = glm::lookAt(camera.Position, camera.Position + camera.Front, camera.Up);
+        Data.viewProjection = Data.projection * Data.view;
+        Data.position = glm::vec4(camera.Position, 1.0f);
+        cameraVersion = camera.Version;
+        valid = true;
+
+        glBindBuffer(GL_UNIFORM_BUFFER, UBO);
+        glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlockData), &Data);
+        return true;
+    }
+
+private:
+    unsigned int UBO;
+    // what Data was computed from
+    unsigned int cameraVersion;
+    float aspect, zoom, nearPlane, farPlane;
+    bool valid;
+};
+#endif
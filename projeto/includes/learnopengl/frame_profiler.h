@@ -0,0 +1,239 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <glad/glad.h>
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+// The parts a frame is split in for profiling, in the order the render loop runs them
+enum Frame_Phase {
+    PHASE_INPUT,
+    PHASE_UPDATE,
+    PHASE_SUBMIT,
+    PHASE_SWAP
+};
+
+const int FRAME_PHASE_COUNT = 4;
+
+inline const char* FramePhaseName(Frame_Phase phase)
+{
+    static const char *names[FRAME_PHASE_COUNT] = {"input", "update", "submit", "swap"};
+    return names[phase];
+}
+
+// Statistics of a series over the profiler's window, in milliseconds
+struct ProfileStats {
+    double last;
+    double average;
+    double min;
+    double max;
+};
+
+// The last samples of a series, kept in a ring so adding one never allocates
+class RollingSeries
+{
+public:
+    RollingSeries(unsigned int capacity = 120) : samples(capacity > 0 ? capacity : 1, 0.0), next(0), count(0) {}
+
+    void Add(double sample)
+    {
+        samples[next] = sample;
+        next = (next + 1) % samples.size();
+        if(count < samples.size())
+            count++;
+    }
+
+    ProfileStats Stats() const
+    {
+        ProfileStats stats = {0.0, 0.0, 0.0, 0.0};
+        if(count == 0)
+            return stats;
+        stats.last = samples[(next + samples.size() - 1) % samples.size()];
+        stats.min = stats.max = stats.last;
+        double sum = 0.0;
+        for(size_t i = 0; i < count; i++)
+        {
+            sum += samples[i];
+            if(samples[i] < stats.min)
+                stats.min = samples[i];
+            if(samples[i] > stats.max)
+                stats.max = samples[i];
+        }
+        stats.average = sum / count;
+        return stats;
+    }
+
+private:
+    std::vector<double> samples;
+    size_t next, count;
+};
+
+// Measures where frames go: CPU time of each Frame_Phase, the whole CPU frame, and the GPU time of the work
+// between BeginGpu and EndGpu. GPU times come from GL_TIME_ELAPSED queries read back QUERY_LATENCY frames later,
+// so reading them never waits for the GPU; a frame's GPU time shows up in the stats that many frames late.
+// Everything is kept over a rolling window of frames, and each frame can also be appended to a CSV file.
+// Timer queries don't nest, so nothing else may time the GPU while a frame is being measured
+class FrameProfiler
+{
+public:
+    static const unsigned int QUERY_LATENCY = 3;
+
+    FrameProfiler(unsigned int window = 120) : frame(window), gpu(window), csv(nullptr), frameIndex(0), phaseStart(0.0), frameStart(0.0), queriesCreated(false)
+    {
+        for(int i = 0; i < FRAME_PHASE_COUNT; i++)
+        {
+            phases.push_back(RollingSeries(window));
+            phaseTimes[i] = 0.0;
+        }
+        for(unsigned int i = 0; i <= QUERY_LATENCY; i++)
+        {
+            queries[i] = 0;
+            queryPending[i] = false;
+        }
+    }
+
+    ~FrameProfiler()
+    {
+        CloseCsv();
+    }
+
+    // starts a frame, and with it the first phase
+    void BeginFrame()
+    {
+        frameStart = phaseStart = now();
+        for(int i = 0; i < FRAME_PHASE_COUNT; i++)
+            phaseTimes[i] = 0.0;
+    }
+
+    // ends the phase running since the last call (or BeginFrame), charging its time to phase
+    void EndPhase(Frame_Phase phase)
+    {
+        double time = now();
+        phaseTimes[phase] += time - phaseStart;
+        phaseStart = time;
+    }
+
+    // brackets the GL commands whose GPU time is measured, once per frame
+    void BeginGpu()
+    {
+        if(!queriesCreated)
+        {
+            glGenQueries(QUERY_LATENCY + 1, queries);
+            queriesCreated = true;
+        }
+        glBeginQuery(GL_TIME_ELAPSED, queries[frameIndex % (QUERY_LATENCY + 1)]);
+    }
+
+    void EndGpu()
+    {
+        glEndQuery(GL_TIME_ELAPSED);
+        queryPending[frameIndex % (QUERY_LATENCY + 1)] = true;
+    }
+
+    // ends the frame: records its phases and collects the GPU time of the oldest query if it's ready
+    void EndFrame()
+    {
+        double total = now() - frameStart;
+        for(int i = 0; i < FRAME_PHASE_COUNT; i++)
+            phases[i].Add(phaseTimes[i]);
+        frame.Add(total);
+
+        double gpuTime = -1.0;
+        unsigned int oldest = (frameIndex + 1) % (QUERY_LATENCY + 1);
+        if(queryPending[oldest])
+        {
+            GLint available = 0;
+            glGetQueryObjectiv(queries[oldest], GL_QUERY_RESULT_AVAILABLE, &available);
+            if(available)
+            {
+                GLuint64 elapsed = 0;
+                glGetQueryObjectui64v(queries[oldest], GL_QUERY_RESULT, &elapsed);
+                gpuTime = elapsed / 1e6;
+                gpu.Add(gpuTime);
+                queryPending[oldest] = false;
+            }
+        }
+
+        if(csv)
+        {
+            fprintf(csv, "%u,%.4f", frameIndex, total);
+            for(int i = 0; i < FRAME_PHASE_COUNT; i++)
+                fprintf(csv, ",%.4f", phaseTimes[i]);
+            // the GPU column belongs to frame frameIndex - QUERY_LATENCY, empty while its query isn't back
+            if(gpuTime >= 0.0)
+                fprintf(csv, ",%.4f\n", gpuTime);
+            else
+                fprintf(csv, ",\n");
+        }
+        frameIndex++;
+    }
+
+    ProfileStats PhaseStats(Frame_Phase phase) const
+    {
+        return phases[phase].Stats();
+    }
+
+    ProfileStats FrameStats() const
+    {
+        return frame.Stats();
+    }
+
+    ProfileStats GpuStats() const
+    {
+        return gpu.Stats();
+    }
+
+    // prints the averages (and worst cases) over the window
+    void Print() const
+    {
+        ProfileStats f = FrameStats(), g = GpuStats();
+        printf("Frame %.2f ms (max %.2f), GPU %.2f ms (max %.2f) |", f.average, f.max, g.average, g.max);
+        for(int i = 0; i < FRAME_PHASE_COUNT; i++)
+        {
+            ProfileStats p = PhaseStats((Frame_Phase)i);
+            printf(" %s %.2f", FramePhaseName((Frame_Phase)i), p.average);
+        }
+        printf("\n");
+    }
+
+    // appends every following frame to the file, returns false if it can't be opened
+    bool OpenCsv(const char *path)
+    {
+        CloseCsv();
+        csv = fopen(path, "w");
+        if(!csv)
+            return false;
+        fprintf(csv, "frame,total_ms");
+        for(int i = 0; i < FRAME_PHASE_COUNT; i++)
+            fprintf(csv, ",%s_ms", FramePhaseName((Frame_Phase)i));
+        fprintf(csv, ",gpu_ms_%u_frames_earlier\n", QUERY_LATENCY);
+        return true;
+    }
+
+    void CloseCsv()
+    {
+        if(csv)
+            fclose(csv);
+        csv = nullptr;
+    }
+
+private:
+    std::vector<RollingSeries> phases;
+    RollingSeries frame;
+    RollingSeries gpu;
+    FILE *csv;
+    unsigned int frameIndex;
+    double phaseTimes[FRAME_PHASE_COUNT];
+    double phaseStart, frameStart;
+    GLuint queries[QUERY_LATENCY + 1];
+    bool queryPending[QUERY_LATENCY + 1];
+    bool queriesCreated;
+
+    static double now()
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+};
+#endif
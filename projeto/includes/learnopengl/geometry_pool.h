@@ -0,0 +1,178 @@
+#ifndef GEOMETRY_POOL_H
+#define GEOMETRY_POOL_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/mesh.h>
+
+#include <cstddef>
+
+// Vertex and index buffers holding the geometry of many meshes, with a single VAO reading them. Positions have a
+// buffer of their own, read alone by depthVAO for depth passes.
+// Meshes are appended the first time they are drawn through the pool; each one remembers where it landed, so
+// any of them can be drawn with the VAO bound by passing that first index and base vertex to the draw call.
+// Used by the multi-draw indirect path, which needs every draw of a call to read the same buffers; and a single
+// index type, so the pool keeps 32 bit indices whatever the meshes use in their own buffers
+class GeometryPool
+{
+public:
+    unsigned int VAO;
+    unsigned int depthVAO;
+
+    GeometryPool() : VAO(0), depthVAO(0), positionVBO(0), VBO(0), EBO(0), instanceVBO(0), instanceOffset(0), instanceLocation(0), vertexCapacity(0), indexCapacity(0), vertexCount(0), indexCount(0), stamp(nextStamp())
+    {
+    }
+
+    // creates the buffers; the per instance matrices are read at instanceMatrixLocation from the buffer given
+    // to SetInstanceSource, indexed by the base instance of each draw
+    void Setup(unsigned int instanceMatrixLocation)
+    {
+        instanceLocation = instanceMatrixLocation;
+        glGenVertexArrays(1, &VAO);
+        glGenVertexArrays(1, &depthVAO);
+        vertexCapacity = 1 << 16;
+        indexCapacity = 1 << 18;
+        positionVBO = createBuffer(vertexCapacity * sizeof(glm::vec3));
+        VBO = createBuffer(vertexCapacity * sizeof(VertexAttributes));
+        EBO = createBuffer(indexCapacity * sizeof(unsigned int));
+        setupAttributes();
+    }
+
+    bool IsSetup() const
+    {
+        return VAO != 0;
+    }
+
+    // points the instance matrix attribute at the matrices starting at offset in buffer
+    void SetInstanceSource(unsigned int buffer, size_t offset)
+    {
+        if(buffer == instanceVBO && offset == instanceOffset)
+            return;
+        instanceVBO = buffer;
+        instanceOffset = offset;
+        setupAttributes();
+    }
+
+    // appends the mesh to the pool unless it's already there
+    void Add(Mesh &mesh)
+    {
+        if(mesh.poolStamp == stamp)
+            return;
+        size_t vertices = mesh.vertices.size();
+        size_t indices = mesh.indices.size();
+        mesh.poolStamp = stamp;
+        mesh.poolBaseVertex = vertexCount;
+        mesh.poolFirstIndex = indexCount;
+        if(vertices == 0 || indices == 0)
+            return;
+        if(vertexCount + vertices > vertexCapacity || indexCount + indices > indexCapacity)
+        {
+            while(vertexCount + vertices > vertexCapacity)
+                vertexCapacity *= 2;
+            while(indexCount + indices > indexCapacity)
+                indexCapacity *= 2;
+            positionVBO = growBuffer(positionVBO, vertexCount * sizeof(glm::vec3), vertexCapacity * sizeof(glm::vec3));
+            VBO = growBuffer(VBO, vertexCount * sizeof(VertexAttributes), vertexCapacity * sizeof(VertexAttributes));
+            EBO = growBuffer(EBO, indexCount * sizeof(unsigned int), indexCapacity * sizeof(unsigned int));
+            setupAttributes();
+        }
+        positions.resize(vertices);
+        attributes.resize(vertices);
+        for(size_t i = 0; i < vertices; i++)
+        {
+            const Vertex &vertex = mesh.vertices[i];
+            positions[i] = vertex.Position;
+            attributes[i].Normal = vertex.Normal;
+            attributes[i].TexCoords = vertex.TexCoords;
+            attributes[i].Tangent = vertex.Tangent;
+            attributes[i].Bitangent = vertex.Bitangent;
+        }
+        // buffers are written through the copy target, binding GL_ELEMENT_ARRAY_BUFFER would change the bound VAO
+        glBindBuffer(GL_COPY_WRITE_BUFFER, positionVBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, vertexCount * sizeof(glm::vec3), vertices * sizeof(glm::vec3), &positions[0]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, VBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, vertexCount * sizeof(VertexAttributes), vertices * sizeof(VertexAttributes), &attributes[0]);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, indexCount * sizeof(unsigned int), indices * sizeof(unsigned int), &mesh.indices[0]);
+        vertexCount += vertices;
+        indexCount += indices;
+    }
+
+private:
+    unsigned int positionVBO, VBO, EBO;
+    unsigned int instanceVBO;
+    size_t instanceOffset;
+    unsigned int instanceLocation;
+    size_t vertexCapacity, indexCapacity;
+    size_t vertexCount, indexCount;
+    // identifies this pool in the meshes added to it
+    unsigned int stamp;
+    // a mesh split in streams while being added, kept to reuse their storage
+    vector<glm::vec3> positions;
+    vector<VertexAttributes> attributes;
+
+    static unsigned int nextStamp()
+    {
+        static unsigned int stamp = 0;
+        return ++stamp;
+    }
+
+    unsigned int createBuffer(size_t size)
+    {
+        unsigned int buffer;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STATIC_DRAW);
+        return buffer;
+    }
+
+    // replaces a buffer with a bigger one holding the same first used bytes
+    unsigned int growBuffer(unsigned int buffer, size_t used, size_t size)
+    {
+        unsigned int bigger = createBuffer(size);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, bigger);
+        if(used > 0)
+            glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+        glDeleteBuffers(1, &buffer);
+        return bigger;
+    }
+
+    // same vertex layout as a mesh with split streams, plus the instance matrix
+    void setupAttributes()
+    {
+        glBindVertexArray(VAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        glBindBuffer(GL_ARRAY_BUFFER, VBO);
+        Mesh::SetupAttributes(sizeof(VertexAttributes), 0);
+        setupInstanceAttribute();
+
+        glBindVertexArray(depthVAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+        setupInstanceAttribute();
+        glBindVertexArray(0);
+    }
+
+    // core profile rejects a pointer into no buffer, so the attribute waits for SetInstanceSource to name one
+    void setupInstanceAttribute()
+    {
+        if(!instanceVBO)
+            return;
+        glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+        for(unsigned int c = 0; c < 4; c++)
+        {
+            glEnableVertexAttribArray(instanceLocation + c);
+            glVertexAttribPointer(instanceLocation + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(instanceOffset + c * sizeof(glm::vec4)));
+            glVertexAttribDivisor(instanceLocation + c, 1);
+        }
+    }
+};
+#endif
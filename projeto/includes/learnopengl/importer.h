@@ -0,0 +1,95 @@
+#ifndef IMPORTER_H
+#define IMPORTER_H
+
+#include <assimp/Importer.hpp>
+#include <assimp/config.h>
+#include <assimp/postprocess.h>
+#include <assimp/scene.h>
+
+// Defines the import profiles a model can be loaded with. Each one picks which assimp post-process steps run,
+// so lightweight loads don't pay for tangent generation or validation they will never use
+enum Import_Profile {
+    IMPORT_FAST_PREVIEW,
+    IMPORT_FULL_QUALITY,
+    IMPORT_COLLISION_ONLY
+};
+
+const int IMPORT_PROFILE_COUNT = 3;
+
+struct ImportSettings {
+    const char *name;
+    unsigned int postProcess;   // aiPostProcessSteps flags handed to ReadFile
+    int removeComponents;       // aiComponent flags stripped when aiProcess_RemoveComponent is set
+    int removePrimitives;       // aiPrimitiveType flags dropped when aiProcess_SortByPType is set
+    bool loadMaterials;         // collision meshes have no use for textures
+};
+
+// Returns the post-process steps and importer properties of a profile
+inline ImportSettings GetImportSettings(Import_Profile profile)
+{
+    ImportSettings s;
+    s.removeComponents = 0;
+    s.removePrimitives = 0;
+    s.loadMaterials = true;
+    switch(profile)
+    {
+    case IMPORT_FAST_PREVIEW:
+        // normals are only generated when the file has none, no tangent space and no validation pass
+        s.name = "fast preview";
+        s.postProcess = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_GenNormals;
+        break;
+    case IMPORT_COLLISION_ONLY:
+        // positions and indices only, everything else is removed before the other steps run
+        s.name = "collision only";
+        s.postProcess = aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_RemoveComponent | aiProcess_SortByPType;
+        s.removeComponents = aiComponent_NORMALS | aiComponent_TANGENTS_AND_BITANGENTS | aiComponent_COLORS |
+                             aiComponent_TEXCOORDS | aiComponent_BONEWEIGHTS | aiComponent_ANIMATIONS |
+                             aiComponent_TEXTURES | aiComponent_LIGHTS | aiComponent_CAMERAS | aiComponent_MATERIALS;
+        s.removePrimitives = aiPrimitiveType_POINT | aiPrimitiveType_LINE;
+        s.loadMaterials = false;
+        break;
+    case IMPORT_FULL_QUALITY:
+    default:
+        s.name = "full quality";
+        s.postProcess = aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace | aiProcess_GenSmoothNormals |
+                        aiProcess_JoinIdenticalVertices | aiProcess_ValidateDataStructure;
+        break;
+    }
+    return s;
+}
+
+// Whether imports split meshes with more vertices than 16 bit indices can address (65536) into pieces that fit,
+// so every mesh gets the smaller index buffer. Off by default: the pieces are extra draws and duplicate the
+// vertices along their seams
+inline bool& SplitForShortIndices()
+{
+    static bool split = false;
+    return split;
+}
+
+// Returns the importer owned by the calling thread. Creating an Assimp::Importer registers every loader and
+// post-process step, so each worker thread keeps one alive and reuses it for all of its loads
+inline Assimp::Importer& GetThreadImporter()
+{
+    static thread_local Assimp::Importer importer;
+    return importer;
+}
+
+// Reads a file with the given profile on the thread's importer. The scene stays owned by the importer
+// until the next read or until FreeScene() is called
+inline const aiScene* ImportScene(const std::string &path, Import_Profile profile)
+{
+    ImportSettings settings = GetImportSettings(profile);
+    Assimp::Importer &importer = GetThreadImporter();
+    // properties persist between reads, so every profile sets all of the ones it depends on
+    importer.SetPropertyInteger(AI_CONFIG_PP_RVC_FLAGS, settings.removeComponents);
+    importer.SetPropertyInteger(AI_CONFIG_PP_SBP_REMOVE, settings.removePrimitives);
+    unsigned int postProcess = settings.postProcess;
+    if(SplitForShortIndices())
+    {
+        postProcess |= aiProcess_SplitLargeMeshes;
+        importer.SetPropertyInteger(AI_CONFIG_PP_SLM_VERTEX_LIMIT, 65536);
+    }
+    return importer.ReadFile(path, postProcess);
+}
+#endif
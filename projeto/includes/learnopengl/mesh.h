@@ -12,6 +12,7 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <map>
 #include <vector>
 using namespace std;
 
@@ -28,19 +29,61 @@ struct Vertex {
     glm::vec3 Bitangent;
 };
 
+// Every attribute but the position, the second stream of a mesh whose positions are stored on their own
+struct VertexAttributes {
+    glm::vec3 Normal;
+    glm::vec2 TexCoords;
+    glm::vec3 Tangent;
+    glm::vec3 Bitangent;
+};
+
+// Whether meshes created from now on keep their positions in a tightly packed buffer of their own, next to one
+// holding the other attributes, instead of interleaving everything. Passes reading positions only (depth, shadows)
+// then fetch 12 bytes a vertex instead of a whole Vertex
+inline bool& SplitVertexStreams()
+{
+    static bool split = true;
+    return split;
+}
+
+// Meshes with at most this many vertices store their indices in 16 bits
+const size_t SHORT_INDEX_VERTEX_LIMIT = 65536;
+
 struct Texture {
     unsigned int id;
     string type;
     string path;
 };
 
+// A texture resolved against a shader program: which unit it goes to and the sampler pointing at that unit, set
+// through its handle so setting it to the unit it already reads costs nothing
+struct TextureBinding {
+    Uniform sampler;
+    unsigned int unit;
+    unsigned int id;
+};
+
 class Mesh {
 public:
     /*  Mesh Data  */
     vector<Vertex> vertices;
     vector<unsigned int> indices;
+    // type of the indices in the element buffer, GL_UNSIGNED_SHORT whenever the vertex count allows it
+    GLenum indexType;
     vector<Texture> textures;
     unsigned int VAO;
+    // reads the positions only, for depth passes; attribute 0 like VAO
+    unsigned int depthVAO;
+    // whether the positions have a buffer of their own
+    bool splitStreams;
+    // small number shared by every mesh using the same set of textures, used to sort draws by material
+    unsigned int materialKey;
+    // Shader_Feature bits its material needs, picks the shader permutation it's drawn with
+    unsigned int shaderFeatures;
+    // where the mesh was copied to in a GeometryPool, valid while poolStamp matches the pool's
+    unsigned int poolStamp;
+    unsigned int poolBaseVertex;
+    unsigned int poolFirstIndex;
 
     /*  Functions  */
     // constructor
@@ -49,89 +92,193 @@ public:
         this->vertices = vertices;
         this->indices = indices;
         this->textures = textures;
+        bindingStamp = 0;
+        materialKey = findMaterialKey(this->textures);
+        shaderFeatures = findShaderFeatures(this->textures);
+        poolStamp = poolBaseVertex = poolFirstIndex = 0;
 
         // now that we have all the required data, set the vertex buffers and its attribute pointers.
         setupMesh();
     }
 
-    // render the mesh
-    void Draw(Shader shader) 
+    // returns the textures to bind for the given program, resolving the sampler names only when the program changed
+    const vector<TextureBinding>& GetBindings(const Shader &shader)
+    {
+        if(bindingStamp != shader.LinkStamp)
+            resolveBindings(shader);
+        return bindings;
+    }
+
+    // size of the element buffer
+    size_t IndexBytes() const
+    {
+        return indices.size() * (indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int));
+    }
+
+    // points attributes 1 to 4 of the bound VAO at the buffer bound to GL_ARRAY_BUFFER, laid out as VertexAttributes starting at
+    // offset, stride bytes apart
+    static void SetupAttributes(size_t stride, size_t offset)
+    {
+        // vertex normals
+        glEnableVertexAttribArray(1);	
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(VertexAttributes, Normal)));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);	
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(VertexAttributes, TexCoords)));
+        // vertex tangent
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(VertexAttributes, Tangent)));
+        // vertex bitangent
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, stride, (void*)(offset + offsetof(VertexAttributes, Bitangent)));
+    }
+
+private:
+    /*  Render data  */
+    unsigned int VBO, EBO;
+    unsigned int positionVBO;   // split streams only
+    // material bindings for the program with link stamp bindingStamp
+    vector<TextureBinding> bindings;
+    unsigned int bindingStamp;
+
+    /*  Functions    */
+    static unsigned int findShaderFeatures(const vector<Texture> &textures)
+    {
+        unsigned int features = 0;
+        for(unsigned int i = 0; i < textures.size(); i++)
+        {
+            if(textures[i].type == "texture_diffuse")
+                features |= SHADER_DIFFUSE_MAP;
+            else if(textures[i].type == "texture_normal")
+                features |= SHADER_NORMAL_MAP;
+            else if(textures[i].type == "texture_specular")
+                features |= SHADER_SPECULAR_MAP;
+        }
+        return features;
+    }
+
+    // gives each distinct list of texture ids its own key, counting from 1 (0 is a mesh without textures)
+    static unsigned int findMaterialKey(const vector<Texture> &textures)
+    {
+        static map<vector<unsigned int>, unsigned int> keys;
+        if(textures.empty())
+            return 0;
+        vector<unsigned int> ids;
+        for(unsigned int i = 0; i < textures.size(); i++)
+            ids.push_back(textures[i].id);
+        map<vector<unsigned int>, unsigned int>::iterator it = keys.find(ids);
+        if(it != keys.end())
+            return it->second;
+        unsigned int key = keys.size() + 1;
+        keys[ids] = key;
+        return key;
+    }
+
+    // looks up the sampler of every texture in the given program. Each diffuse texture is expected to be
+    // named 'texture_diffuseN' where N counts from 1, and the same for the specular, normal and height ones
+    void resolveBindings(const Shader &shader)
     {
-        // bind appropriate textures
         unsigned int diffuseNr  = 1;
         unsigned int specularNr = 1;
         unsigned int normalNr   = 1;
         unsigned int heightNr   = 1;
+        bindings.clear();
         for(unsigned int i = 0; i < textures.size(); i++)
         {
-            glActiveTexture(GL_TEXTURE0 + i); // active proper texture unit before binding
             // retrieve texture number (the N in diffuse_textureN)
             string number;
             string name = textures[i].type;
             if(name == "texture_diffuse")
-				number = std::to_string(diffuseNr++);
-			else if(name == "texture_specular")
-				number = std::to_string(specularNr++); // transfer unsigned int to stream
+                number = std::to_string(diffuseNr++);
+            else if(name == "texture_specular")
+                number = std::to_string(specularNr++);
             else if(name == "texture_normal")
-				number = std::to_string(normalNr++); // transfer unsigned int to stream
-             else if(name == "texture_height")
-			    number = std::to_string(heightNr++); // transfer unsigned int to stream
-
-													 // now set the sampler to the correct texture unit
-            glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
-            // and finally bind the texture
-            glBindTexture(GL_TEXTURE_2D, textures[i].id);
-        }
-        
-        // draw mesh
-        glBindVertexArray(VAO);
-        glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
-        glBindVertexArray(0);
+                number = std::to_string(normalNr++);
+            else if(name == "texture_height")
+                number = std::to_string(heightNr++);
 
-        // always good practice to set everything back to defaults once configured.
-        glActiveTexture(GL_TEXTURE0);
+            // samplers the program doesn't use are skipped altogether
+            TextureBinding binding;
+            binding.sampler = shader.getUniform(name + number);
+            binding.unit = i;
+            binding.id = textures[i].id;
+            if(binding.sampler.isValid())
+                bindings.push_back(binding);
+        }
+        bindingStamp = shader.LinkStamp;
     }
 
-private:
-    /*  Render data  */
-    unsigned int VBO, EBO;
-
-    /*  Functions    */
     // initializes all the buffer objects/arrays
     void setupMesh()
     {
+        splitStreams = SplitVertexStreams();
         // create buffers/arrays
         glGenVertexArrays(1, &VAO);
+        glGenVertexArrays(1, &depthVAO);
         glGenBuffers(1, &VBO);
         glGenBuffers(1, &EBO);
+        positionVBO = 0;
 
         glBindVertexArray(VAO);
-        // load data into vertex buffers
-        glBindBuffer(GL_ARRAY_BUFFER, VBO);
-        // A great thing about structs is that their memory layout is sequential for all its items.
-        // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-        // again translates to 3/2 floats which translates to a byte array.
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
-
         glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        // half the index memory and bandwidth when every index fits in 16 bits
+        if(vertices.size() <= SHORT_INDEX_VERTEX_LIMIT)
+        {
+            indexType = GL_UNSIGNED_SHORT;
+            vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, shortIndices.size() * sizeof(unsigned short), &shortIndices[0], GL_STATIC_DRAW);
+        }
+        else
+        {
+            indexType = GL_UNSIGNED_INT;
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
+        }
 
-        // set the vertex attribute pointers
-        // vertex Positions
-        glEnableVertexAttribArray(0);	
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-        // vertex normals
-        glEnableVertexAttribArray(1);	
-        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-        // vertex texture coords
-        glEnableVertexAttribArray(2);	
-        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-        // vertex tangent
-        glEnableVertexAttribArray(3);
-        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-        // vertex bitangent
-        glEnableVertexAttribArray(4);
-        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
+        if(splitStreams)
+        {
+            // positions and the remaining attributes go to two buffers, each tightly packed
+            vector<glm::vec3> positions(vertices.size());
+            vector<VertexAttributes> attributes(vertices.size());
+            for(unsigned int i = 0; i < vertices.size(); i++)
+            {
+                positions[i] = vertices[i].Position;
+                attributes[i].Normal = vertices[i].Normal;
+                attributes[i].TexCoords = vertices[i].TexCoords;
+                attributes[i].Tangent = vertices[i].Tangent;
+                attributes[i].Bitangent = vertices[i].Bitangent;
+            }
+            glGenBuffers(1, &positionVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, positionVBO);
+            glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), &positions[0], GL_STATIC_DRAW);
+            glEnableVertexAttribArray(0);
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            glBufferData(GL_ARRAY_BUFFER, attributes.size() * sizeof(VertexAttributes), &attributes[0], GL_STATIC_DRAW);
+            SetupAttributes(sizeof(VertexAttributes), 0);
+        }
+        else
+        {
+            // load data into vertex buffers
+            glBindBuffer(GL_ARRAY_BUFFER, VBO);
+            // A great thing about structs is that their memory layout is sequential for all its items.
+            // The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
+            // again translates to 3/2 floats which translates to a byte array.
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+
+            // set the vertex attribute pointers
+            // vertex Positions
+            glEnableVertexAttribArray(0);	
+            glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+            SetupAttributes(sizeof(Vertex), offsetof(Vertex, Normal));
+        }
+
+        // the depth VAO shares the buffers, reading the positions alone
+        glBindVertexArray(depthVAO);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
+        glBindBuffer(GL_ARRAY_BUFFER, splitStreams ? positionVBO : VBO);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, splitStreams ? sizeof(glm::vec3) : sizeof(Vertex), (void*)0);
 
         glBindVertexArray(0);
     }
@@ -5,14 +5,16 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
-#include <glm/gtx/spline.hpp>
 #include <glm/gtx/vector_angle.hpp>
 #include <stb_image.h>
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
 
+#include <learnopengl/animation.h>
+#include <learnopengl/importer.h>
 #include <learnopengl/mesh.h>
+#include <learnopengl/render_queue.h>
 #include <learnopengl/shader.h>
 
 #include <string>
@@ -21,68 +23,15 @@
 #include <iostream>
 #include <map>
 #include <vector>
-#include <queue>
+#include <memory>
 
 using namespace std;
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma = false);
 
-struct rotationAxis {
-    float finalAngle;
-    float inicialTime;  // Time that the trasformation began
-    float endingTime;   // Time for the transformation to end
-    glm::vec3 axis;
-    bool ended;
-};
-
-struct rotationRoundPoint {
-    float angle;
-    glm::vec3 axis;
-    glm::vec3 point;
-    float inicialTime;
-    float endingTime;
-    bool ended;
-};
-
-struct translation {
-    glm::vec3 newPosition;
-    glm::vec3 inicialPosition;
-    float inicialTime;  // Time that the trasformation began
-    float endingTime;   // Time for the transformation to end
-    bool ended;
-};
-
-struct scale {
-    glm::vec3 scale;
-    glm::vec3 inicialScale;
-    float inicialTime;  // Time that the trasformation began
-    float endingTime;   // Time for the transformation to end
-    bool ended;
-};
-
-struct shear {
-    // x = 0, y = 1, x = 0
-    int axis;
-    float inicialFirstValue;
-    float inicialSecondValue;
-    float firstValue;
-    float secondValue;
-    float inicialTime;
-    float time;
-    bool ended;
-};
-
-struct spline {
-    glm::vec3 p0;
-    glm::vec3 p1;
-    glm::vec3 p2;
-    glm::vec3 p3;
-    float inicialTime;
-    float time;
-    bool ended;
-};
-
-class Model 
+// The meshes and textures loaded from a model file. Loading is done once per file and import profile,
+// every Model created from the same file shares the same asset (and thus the same GPU buffers)
+class ModelAsset
 {
 public:
     /*  Model Data */
@@ -90,527 +39,23 @@ public:
     vector<Mesh> meshes;
     string directory;
     bool gammaCorrection;
+    Import_Profile importProfile;
 
     /*  Functions   */
-    // constructor, expects a filepath to a 3D model.
-    Model(string const &path, bool gamma = false) : gammaCorrection(gamma)
+    // constructor, expects a filepath to a 3D model and the profile it is imported with.
+    // Prefer LoadModelAsset, which returns the already loaded asset when there is one
+    ModelAsset(string const &path, bool gamma = false, Import_Profile profile = IMPORT_FULL_QUALITY) : gammaCorrection(gamma), importProfile(profile)
     {
-        currPosition = glm::vec3(0);
-        // Scale
-        currScale = glm::vec3(1);
-        // Rotation
-        upVector = glm::vec3(0,1,0);
-        frontVector = glm::vec3(0,0,1);
-        requestedRotation = false;
-
-        // Shear
-        shearValue1 = 0;
-        shearValue2 = 0;
-        shearAxis = 0;
-        
-        currBezier.ended = true;
-        currBSpline.ended = true;
-        currRotating.ended = true;
-        currTranslating.ended = true;
-        currScaling.ended = true;
-        currShearing.ended = true;
-        currRPRotation.ended = true;
-        currPosition = glm::vec3(0,0,0);
-        currScale = glm::vec3(1,1,1);
         loadModel(path);
     }
 
-    // draws the model, and thus all its meshes
-    void Draw(Shader shader)
-    {
-        for(unsigned int i = 0; i < meshes.size(); i++)
-            meshes[i].Draw(shader);
-    }
-    
-    // Translates model from current position to new Position in a certain time in seconds
-    void Translate(glm::vec3 nPos, float timeTaken){
-        // If time == 0 then Translates instantly
-        translation t;
-        t.newPosition = nPos;
-        t.endingTime = timeTaken;
-        t.ended = false;
-        translations.push(t);
-    }
-
-    // Scales model using 3 values (x, y, z) in a certain time in seconds
-    void Scale(glm::vec3 nScale, float time){
-        scale s;
-        s.endingTime = time;
-        s.scale = nScale;
-        s.ended = false;
-        scales.push(s);
-    }
-
-    // Rotates model in a certain angle, in a certain time in seconds around a specific axis
-    void RotateAx(float angle, float timeTaken, glm::vec3 axis){
-        rotationAxis r;
-        r.endingTime = timeTaken;
-        r.finalAngle = angle;    // Converts from degrees to radians
-        r.axis = axis;
-        rotations.push(r);
-    }
-
-    void RotatePoint(float angle, float timeTaken, glm::vec3 point){
-        rotationRoundPoint r;
-        r.angle = angle;
-        r.ended = false;
-        r.endingTime = timeTaken;
-        r.point = point;
-        rpRotations.push(r);
-
-        requestedRotation = true;
-    }
-
-    void BezierCurve(
-        glm::vec3 p0,
-        glm::vec3 p1,
-        glm::vec3 p2,
-        glm::vec3 p3,
-        float time)
-    {
-        spline b;
-        b.p0 = p0;
-        b.p1 = p1;
-        b.p2 = p2;
-        b.p3 = p3;
-        b.time = time;
-        b.ended = false;
-        bezierCurves.push(b);
-    }
-
-     void BSplineCurve(
-        glm::vec3 p0,
-        glm::vec3 p1,
-        glm::vec3 p2,
-        glm::vec3 p3,
-        float time)
-    {
-        spline b;
-        b.p0 = p0;
-        b.p1 = p1;
-        b.p2 = p2;
-        b.p3 = p3;
-        b.time = time;
-        b.ended = false;
-        bSplineCurves.push(b);
-    }
-
-    // Shears
-    void ShearX(float y, float z, float time){
-        shear s;
-        // Gets x axis (0)
-        s.axis = 0; 
-        s.ended = false;
-        s.time = time;
-        s.firstValue = y;
-        s.secondValue = z;
-        //transform[1][0] = y;
-        //transform[2][0] = z;
-        shears.push(s);
-    }
-
-    void ShearY(float x, float z, float time){
-        shear s;
-        // Gets y axis (1)
-        s.axis = 1; 
-        s.ended = false;
-        s.time = time;
-        s.firstValue = z;
-        s.secondValue = x;
-        //transform[0][1] = 1;
-        //transform[2][1] = 1;
-        shears.push(s);
-    }
-
-    void ShearZ(float x, float y, float time){
-        shear s;
-        // Gets z axis (2)
-        s.axis = 2; 
-        s.ended = false;
-        s.time = time;
-        s.firstValue = x;
-        s.secondValue = y;
-        //transform[0][2] = 1;
-        //transform[1][2] = 1;
-        shears.push(s);
-    }
-
-    // Returns a trasformation matrix to be used on model movements and refreshes model's attributes
-    glm::mat4 TrasformationMatrix(float currentTime){
-        this->currTime = currentTime;
-        // Scales, Translates, rotates and then shears, acording to the first elements of the queues
-        currPosition = bSplinePosition();
-        currPosition = bezierPosition();
-        currPosition = translateVector();
-        glm::mat4 transform(1.0);
-    
-        glm::mat4 translate = glm::translate(transform, currPosition);
-        glm::mat4 shear = shearMatrix(translate);
-        glm::mat4 scale = glm::scale(shear, scaleVector());
-
-        glm::mat4 rotationMatrix;
-        rotationMatrix = rotationData();
-        if(requestedRotation || !currRPRotation.ended){
-            requestedRotation = false;
-            rotationMatrix = roundPointRotationMatrix();
-            return rotationMatrix * scale;
-        }
-
-        return scale * rotationMatrix;
-    }
-    
-
 private:
-    // Postion
-    glm::vec3 currPosition;
-    // Scale
-    glm::vec3 currScale;
-    // Rotation
-    glm::vec3 upVector;
-    glm::vec3 frontVector;
-    bool requestedRotation;
-    
-    //glm::mat4 rotationMatrix;
-    // Shear
-    float shearValue1;
-    float shearValue2;
-    int shearAxis;
-    // Time
-    float currTime;
-
-    queue<translation> translations;
-    queue<scale> scales;
-    queue<rotationAxis> rotations;
-    queue<shear> shears;
-    queue<rotationRoundPoint> rpRotations;
-    queue<spline> bezierCurves;
-    queue<spline> bSplineCurves;
-
-    translation currTranslating;
-    scale currScaling;
-    rotationAxis currRotating;
-    rotationRoundPoint currRPRotation;
-    spline currBezier;
-    spline currBSpline;
-    shear currShearing;
-
-    /*  Functions   */
-    glm::vec3 translateVector(){
-        if(currTranslating.ended){
-            if(!translations.empty()){
-                currTranslating = translations.front();
-                currTranslating.ended = false;
-                currTranslating.inicialPosition = currPosition;
-                currTranslating.inicialTime = currTime;
-                currTranslating.endingTime += currTime;
-                translations.pop(); 
-            }
-            else {
-                return currPosition;
-            }
-        }
-        // if reached this line, has a currTranslation going on
-        // Percentage of trasformation that has to be done
-        translation t = currTranslating;
-        float percentage = (this->currTime - t.inicialTime) / (t.endingTime - t.inicialTime);
-        // if should already had transformed, do it and pops from the queue
-        if(percentage >= 1){
-            currTranslating.ended = true;
-            this->currPosition = t.newPosition;
-        }
-        else {
-            // otherwise, calculate how much must be translate and does it (refreshing the currPosition)
-            this->currPosition.x = t.inicialPosition.x + percentage * (t.newPosition.x - t.inicialPosition.x);
-            this->currPosition.y = t.inicialPosition.y + percentage * (t.newPosition.y - t.inicialPosition.y);
-            this->currPosition.z = t.inicialPosition.z + percentage * (t.newPosition.z - t.inicialPosition.z);
-        }
-        return currPosition;
-    }
-
-    // Shear
-    glm::mat4 shearMatrix(glm::mat4 transform) {
-       
-        if(currShearing.ended){
-            if(!shears.empty()){
-                currShearing = shears.front();
-                currShearing.ended = false;
-                currShearing.inicialTime = currTime;
-                currShearing.time += currTime;
-                currShearing.inicialFirstValue = 0;
-                currShearing.inicialSecondValue = 0;
-                // Resets shear status
-                shearAxis = currShearing.axis;
-                shearValue1 = 0;
-                shearValue2 = 0;
-                // Pops from queue
-                shears.pop();
-            }
-            else {
-                glm::mat4 sMatrix(1);
-                sMatrix[(shearAxis + 1) % 3][shearAxis] = this->shearValue1;
-                sMatrix[(shearAxis + 2) % 3][shearAxis] = this->shearValue2;
-                return transform * sMatrix;
-            }
-        }
-
-        shear s = currShearing;
-        float percentage = (this->currTime - s.inicialTime) / (s.time - s.inicialTime);
-        if(percentage >= 1){
-            currShearing.ended = true;
-            this->shearValue1 = s.firstValue;
-            this->shearValue2 = s.secondValue;
-        }
-        else {
-            this->shearValue1 = s.inicialFirstValue + percentage * (s.firstValue - s.inicialFirstValue);
-            this->shearValue2 = s.inicialSecondValue + percentage * (s.secondValue - s.inicialSecondValue);
-        }
-
-        glm::mat4 sMatrix(1);
-        sMatrix[(shearAxis + 1) % 3][shearAxis] = this->shearValue1;
-        sMatrix[(shearAxis + 2) % 3][shearAxis] = this->shearValue2;
-        return transform * sMatrix;
-
-    }
-
-
-    glm::mat4 myLookAt(glm::vec3 up, glm::vec3 front){
-        glm::mat4 rotMatrix = glm::mat4(1);
-        glm::vec4 rightVec = glm::vec4(glm::normalize(glm::cross(front, up)), 0);
-        rotMatrix[0][0] = rightVec.x;
-        rotMatrix[0][1] = rightVec.y;
-        rotMatrix[0][2] = rightVec.z;
-        rotMatrix[1][0] = up.x;
-        rotMatrix[1][1] = up.y;
-        rotMatrix[1][2] = up.z;
-        rotMatrix[2][0] = front.x;
-        rotMatrix[2][1] = front.y;
-        rotMatrix[2][2] = front.z;
-
-        return rotMatrix;
-    }
-
-    glm::mat4 rotationData(){
-
-        if(currRotating.ended){
-            if(!rotations.empty()){
-                currRotating = rotations.front();
-                currRotating.ended = false;   
-                currRotating.inicialTime = currTime;
-                currRotating.endingTime += currTime;
-                rotations.pop(); 
-            }
-            else {
-                return myLookAt(upVector, frontVector);
-            }
-        }
-
-        glm::mat4 rMatrix = myLookAt(upVector, frontVector);
-        rotationAxis rt = currRotating;
-        float percentage = (currTime - rt.inicialTime) / (rt.endingTime - rt.inicialTime);
-        float angle;
-        
-        glm::mat4 rotate;
-        if(percentage < 1){
-            angle = rt.finalAngle * percentage;
-            rotate = glm::rotate(glm::mat4(1), angle, rt.axis);
-            return rotate * rMatrix;
-        }
-
-        currRotating.ended = true;
-        angle = rt.finalAngle;
-        rotate = glm::rotate(glm::mat4(1), angle, rt.axis);
-        
-        glm::vec4 newPosition = glm::vec4(currPosition, 1);
-        newPosition = newPosition * rotate;
-        glm::vec4 newFront = glm::vec4((currPosition + frontVector), 1);
-        newFront = newFront * rotate;
-        glm::vec4 newUp = glm::vec4((currPosition + upVector), 1);
-        newUp = newUp * rotate;
-
-        currPosition = glm::vec3(newPosition.x, newPosition.y, newPosition.z);
-        frontVector = glm::vec3(newFront.x, newFront.y, newFront.z) - currPosition;
-        upVector = glm::vec3(newUp.x, newUp.y, newUp.z) - currPosition;
-
-        return myLookAt(upVector, frontVector); 
-
-    }
-
-    glm::vec3 scaleVector(){
-        if(currScaling.ended){
-            if(!scales.empty()){
-                currScaling = scales.front();
-                currScaling.ended = false;
-                currScaling.inicialScale = currScale;
-                currScaling.inicialTime = currTime;
-                currScaling.endingTime += currTime;
-                scales.pop(); 
-            }
-            else {
-                return currScale;
-            }
-        }
-
-        scale s = currScaling;
-        float percentage = (this->currTime - s.inicialTime) / (s.endingTime - s.inicialTime);
-        if(percentage >= 1){
-            currScaling.ended = true;
-            this->currScale = s.scale;
-        }
-        else {
-            this->currScale.x = s.inicialScale.x + percentage * (s.scale.x - s.inicialScale.x);
-            this->currScale.y = s.inicialScale.y + percentage * (s.scale.y - s.inicialScale.y);    
-            this->currScale.z = s.inicialScale.z + percentage * (s.scale.z - s.inicialScale.z);
-        }
-        return currScale;
-    }
-
-    glm::mat4 roundPointRotationMatrix(){
-
-        if(currRPRotation.ended){
-            if(!rpRotations.empty()){
-                currRPRotation = rpRotations.front();
-
-                glm::vec3 newFrontVector;
-                if(currRPRotation.point != currPosition)
-                    newFrontVector = glm::normalize(currRPRotation.point - currPosition);
-                else
-                    newFrontVector = frontVector;
-
-                newFrontVector = glm::normalize(newFrontVector);
-                if(newFrontVector != frontVector && (newFrontVector + frontVector) != glm::vec3(0)){
-                    upVector = glm::normalize(glm::cross(frontVector, newFrontVector));
-                    if(upVector.y <= 0.0)    
-                            upVector *= -1;
-                }
-                
-                frontVector = newFrontVector;
-
-                currRPRotation.inicialTime = currTime;
-                currRPRotation.endingTime += currTime;
-                currRPRotation.ended = false;
-                rpRotations.pop();
-            }
-            else {
-                return glm::mat4(1.0);
-            }
-        }
-        
-        glm::mat4 rMatrix(1);
-        rotationRoundPoint r = currRPRotation;
-        float currAngle = r.angle;
-        float percentage = (this->currTime - r.inicialTime) / (r.endingTime - r.inicialTime);
-        if(percentage >= 1){
-            currRPRotation.ended = true;
-            rMatrix = glm::translate(rMatrix, r.point);
-            rMatrix = glm::rotate(rMatrix, currAngle, upVector);
-            rMatrix = glm::translate(rMatrix, -(r.point));
-
-            glm::vec4 auxPosition = glm::vec4(currPosition, 1) * rMatrix;
-            currPosition = glm::vec3(auxPosition.x, auxPosition.y, auxPosition.z);
-            frontVector = glm::normalize(currRPRotation.point - currPosition);
-            
-            return rMatrix;
-        }
-        else {
-            currAngle = percentage * (r.angle);
-            rMatrix = glm::translate(rMatrix, r.point);
-            rMatrix = glm::rotate(rMatrix, currAngle, upVector);
-            rMatrix = glm::translate(rMatrix, -(r.point));
-
-            return rMatrix;
-        }
-        
-    }
-
-    glm::vec3 bSplinePosition(){
-        if(currBSpline.ended){
-            if(!bSplineCurves.empty()){
-                currBSpline = bSplineCurves.front();
-                currBSpline.inicialTime = currTime;
-                currBSpline.time += currTime;
-                currBSpline.ended = false;
-                bSplineCurves.pop();
-            }
-            else {
-                return currPosition;
-            }
-        }
-        
-        spline b = currBSpline;
-        float percentage = (this->currTime - b.inicialTime) / (b.time - b.inicialTime);
-        if(percentage >= 1){
-            currBSpline.ended = true;
-            currPosition = b.p3;
-            return currPosition;
-        }
-
-        glm::vec3 v;
-        if(percentage <= 0.333333333){
-            v = glm::catmullRom(b.p0, b.p0, b.p1, b.p2, 3 * percentage); 
-        }
-        else{
-            if(percentage <= 0.666666666){
-                v = glm::catmullRom(b.p0, b.p1, b.p2, b.p3, 3 * (percentage - 0.333333333));    
-            }
-            else {
-                v = glm::catmullRom(b.p1, b.p2, b.p3, b.p3, 3 * (percentage - 0.666666666));    
-            }
-        }
-
-        //printf("%f %f %f\n", v.x, v.y, v.z);
-        return v;
-    }
-
-
-    // Cubic Bézier curve Equation
-    glm::vec3 Bezier(spline b, float t){
-        return (float)pow(1-t, 3) * b.p0 + 
-               3 * (float)pow(1-t, 2) * t * b.p1 +
-               3 * (1-t) * (float)pow(t, 2) * b.p2 +
-               (float)pow(t, 3) * b.p3;
-    }
-
-    glm::vec3 bezierPosition(){
-
-        if(currBezier.ended){
-            if(!bezierCurves.empty()){
-                currBezier = bezierCurves.front();
-                currBezier.inicialTime = currTime;
-                currBezier.time += currTime;
-                currBezier.ended = false;
-                bezierCurves.pop();
-            }
-            else {
-                return currPosition;
-            }
-        }
-        
-        spline b = currBezier;
-        float percentage = (this->currTime - b.inicialTime) / (b.time - b.inicialTime);
-        if(percentage >= 1){
-            currBezier.ended = true;
-            currPosition = currBezier.p3;
-            return currPosition;
-        }
-        else {
-            glm::vec3 v = Bezier(currBezier, percentage);
-            //printf("%f %f %f\n", v.x, v.y, v.z);
-            return v;
-        }
-    }
-
-
     // loads a model with supported ASSIMP extensions from file and stores the resulting meshes in the meshes vector.
     void loadModel(string const &path)
     {
-        // read file via ASSIMP
-        Assimp::Importer importer;
-        const aiScene* scene = importer.ReadFile(path, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_CalcTangentSpace);
+        // read file via ASSIMP, reusing this thread's importer
+        Assimp::Importer &importer = GetThreadImporter();
+        const aiScene* scene = ImportScene(path, importProfile);
         // check for errors
         if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) // if is Not Zero
         {
@@ -622,6 +67,8 @@ private:
 
         // process ASSIMP's root node recursively
         processNode(scene->mRootNode, scene);
+        // the importer outlives this load, so release the imported scene right away
+        importer.FreeScene();
     }
 
     // processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
@@ -660,11 +107,16 @@ private:
             vector.y = mesh->mVertices[i].y;
             vector.z = mesh->mVertices[i].z;
             vertex.Position = vector;
-            // normals
-            vector.x = mesh->mNormals[i].x;
-            vector.y = mesh->mNormals[i].y;
-            vector.z = mesh->mNormals[i].z;
-            vertex.Normal = vector;
+            // normals (stripped by the collision profile)
+            if(mesh->mNormals)
+            {
+                vector.x = mesh->mNormals[i].x;
+                vector.y = mesh->mNormals[i].y;
+                vector.z = mesh->mNormals[i].z;
+                vertex.Normal = vector;
+            }
+            else
+                vertex.Normal = glm::vec3(0.0f, 0.0f, 0.0f);
             // texture coordinates
             if(mesh->mTextureCoords[0]) // does the mesh contain texture coordinates?
             {
@@ -677,16 +129,23 @@ private:
             }
             else
                 vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-            // tangent
-            vector.x = mesh->mTangents[i].x;
-            vector.y = mesh->mTangents[i].y;
-            vector.z = mesh->mTangents[i].z;
-            vertex.Tangent = vector;
-            // bitangent
-            vector.x = mesh->mBitangents[i].x;
-            vector.y = mesh->mBitangents[i].y;
-            vector.z = mesh->mBitangents[i].z;
-            vertex.Bitangent = vector;
+            // tangent and bitangent (only generated by the full quality profile)
+            if(mesh->mTangents && mesh->mBitangents)
+            {
+                vector.x = mesh->mTangents[i].x;
+                vector.y = mesh->mTangents[i].y;
+                vector.z = mesh->mTangents[i].z;
+                vertex.Tangent = vector;
+                vector.x = mesh->mBitangents[i].x;
+                vector.y = mesh->mBitangents[i].y;
+                vector.z = mesh->mBitangents[i].z;
+                vertex.Bitangent = vector;
+            }
+            else
+            {
+                vertex.Tangent = glm::vec3(0.0f, 0.0f, 0.0f);
+                vertex.Bitangent = glm::vec3(0.0f, 0.0f, 0.0f);
+            }
             vertices.push_back(vertex);
         }
         // now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
@@ -697,6 +156,10 @@ private:
             for(unsigned int j = 0; j < face.mNumIndices; j++)
                 indices.push_back(face.mIndices[j]);
         }
+        // collision meshes carry no materials
+        if(!GetImportSettings(importProfile).loadMaterials)
+            return Mesh(vertices, indices, textures);
+
         // process materials
         aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];    
         // we assume a convention for sampler names in the shaders. Each diffuse texture should be named
@@ -757,6 +220,180 @@ private:
     }
 };
 
+// Returns the asset of a model file, loading it only the first time it is asked for
+inline shared_ptr<ModelAsset> LoadModelAsset(string const &path, bool gamma = false, Import_Profile profile = IMPORT_FULL_QUALITY)
+{
+    static map<string, shared_ptr<ModelAsset> > assets;
+    string key = path + (gamma ? "|gamma|" : "|linear|") + GetImportSettings(profile).name + (SplitForShortIndices() ? "|split" : "");
+    map<string, shared_ptr<ModelAsset> >::iterator it = assets.find(key);
+    if(it != assets.end())
+        return it->second;
+    shared_ptr<ModelAsset> asset = make_shared<ModelAsset>(path, gamma, profile);
+    assets[key] = asset;
+    return asset;
+}
+
+// A placed and animated instance of a model asset
+class Model 
+{
+public:
+    /*  Model Data */
+    shared_ptr<ModelAsset> asset;
+
+    /*  Functions   */
+    // constructor, expects a filepath to a 3D model and optionally the profile it is imported with.
+    Model(string const &path, bool gamma = false, Import_Profile profile = IMPORT_FULL_QUALITY) : asset(LoadModelAsset(path, gamma, profile)), instance(Animations().Create())
+    {
+    }
+
+    // a copy is another instance of the same asset, in the same state and with the same transformations pending
+    Model(const Model &other) : asset(other.asset), instance(Animations().Clone(other.instance))
+    {
+    }
+
+    Model(Model &&other) noexcept : asset(std::move(other.asset)), instance(other.instance)
+    {
+        other.instance = ANIMATION_NONE;
+    }
+
+    Model& operator=(Model other)
+    {
+        std::swap(asset, other.asset);
+        std::swap(instance, other.instance);
+        return *this;
+    }
+
+    ~Model()
+    {
+        if(instance != ANIMATION_NONE)
+            Animations().Destroy(instance);
+    }
+
+    // records the model's meshes in a render queue, to be drawn when the queue is flushed
+    void Submit(RenderQueue &queue, const Shader &shader, const glm::mat4 &model)
+    {
+        queue.Submit(shader, asset->meshes, model);
+    }
+
+    // same, each mesh drawn with the shader permutation its material needs
+    void Submit(RenderQueue &queue, ShaderPermutations &shaders, const glm::mat4 &model)
+    {
+        queue.Submit(shaders, asset->meshes, model);
+    }
+    
+    // Translates model from current position to new Position in a certain time in seconds
+    void Translate(glm::vec3 nPos, float timeTaken){
+        // If time == 0 then Translates instantly
+        TranslationOp t;
+        t.target = nPos;
+        Animations().Translate(instance, t, timeTaken);
+    }
+
+    // Scales model using 3 values (x, y, z) in a certain time in seconds
+    void Scale(glm::vec3 nScale, float time){
+        ScaleOp s;
+        s.target = nScale;
+        Animations().Scale(instance, s, time);
+    }
+
+    // Rotates model in a certain angle, in a certain time in seconds around a specific axis
+    void RotateAx(float angle, float timeTaken, glm::vec3 axis){
+        AxisRotationOp r;
+        r.angle = angle;
+        r.axis = axis;
+        Animations().Rotate(instance, r, timeTaken);
+    }
+
+    void RotatePoint(float angle, float timeTaken, glm::vec3 point){
+        RoundPointOp r;
+        r.angle = angle;
+        r.point = point;
+        Animations().RotateAround(instance, r, timeTaken);
+    }
+
+    void BezierCurve(
+        glm::vec3 p0,
+        glm::vec3 p1,
+        glm::vec3 p2,
+        glm::vec3 p3,
+        float time,
+        bool constantSpeed = false)
+    {
+        CurveOp b;
+        b.p0 = p0;
+        b.p1 = p1;
+        b.p2 = p2;
+        b.p3 = p3;
+        Animations().Bezier(instance, b, time, constantSpeed);
+    }
+
+     void BSplineCurve(
+        glm::vec3 p0,
+        glm::vec3 p1,
+        glm::vec3 p2,
+        glm::vec3 p3,
+        float time)
+    {
+        CurveOp b;
+        b.p0 = p0;
+        b.p1 = p1;
+        b.p2 = p2;
+        b.p3 = p3;
+        Animations().BSpline(instance, b, time);
+    }
+
+    // follows a spline added to Animations() with AddSpline, from its start to its end
+    void FollowSpline(unsigned int spline, float time){
+        Animations().FollowSpline(instance, spline, time);
+    }
+
+    // Shears
+    void ShearX(float y, float z, float time){
+        // Gets x axis (0)
+        shear(0, y, z, time);
+    }
+
+    void ShearY(float x, float z, float time){
+        // Gets y axis (1)
+        shear(1, z, x, time);
+    }
+
+    void ShearZ(float x, float y, float time){
+        // Gets z axis (2)
+        shear(2, x, y, time);
+    }
+
+    // Makes the model move with parent, its transformations then taking place in the parent's model space, like a
+    // moon around a planet; nullptr frees it. Returns false, changing nothing, if parent is this model or one of
+    // its children
+    bool SetParent(const Model *parent){
+        return Animations().SetParent(instance, parent ? parent->Instance() : ANIMATION_NONE);
+    }
+
+    // The model's transformation matrix as of the last Animations().Update
+    const glm::mat4& WorldMatrix() const
+    {
+        return Animations().Matrix(instance);
+    }
+
+    // id of the model's instance in the animation system
+    unsigned int Instance() const
+    {
+        return instance;
+    }
+
+private:
+    unsigned int instance;
+
+    void shear(int axis, float firstValue, float secondValue, float time){
+        ShearOp s;
+        s.axis = axis;
+        s.firstValue = firstValue;
+        s.secondValue = secondValue;
+        Animations().Shear(instance, s, time);
+    }
+};
+
 
 unsigned int TextureFromFile(const char *path, const string &directory, bool gamma)
 {
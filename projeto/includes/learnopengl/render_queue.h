@@ -0,0 +1,487 @@
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include <glad/glad.h>
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/geometry_pool.h>
+#include <learnopengl/mesh.h>
+#include <learnopengl/ring_buffer.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/shader_library.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+// Vertex shaders read the model matrix of each instance from this attribute, a mat4 taking four locations
+const unsigned int INSTANCE_MATRIX_LOCATION = 5;
+
+// How many state changes the last flush of a render queue made
+struct RenderStats {
+    unsigned int apiCalls;      // every GL call the flush made, uploads included
+    unsigned int drawCalls;
+    unsigned int instances;
+    unsigned int programChanges;
+    unsigned int materialChanges;
+    unsigned int vaoChanges;
+    unsigned int textureBinds;
+};
+
+// A draw recorded during the frame. The key packs the state it needs so sorting the keys groups draws
+// sharing a program, then a material, then a VAO, and finally orders them front to back:
+//   bits 56-63 program | 36-55 material | 16-35 VAO | 0-15 depth
+// The program field holds the order in which the frame first recorded the program, not its link stamp, which
+// keeps growing as programs are reloaded
+struct DrawPacket {
+    uint64_t key;
+    const Shader *shader;
+    Mesh *mesh;
+    unsigned int matrix;    // index of the model matrix in the queue
+};
+
+inline bool operator<(const DrawPacket &a, const DrawPacket &b)
+{
+    return a.key < b.key;
+}
+
+// A run of sorted packets drawing the same mesh with the same program, issued as one instanced draw
+struct DrawBatch {
+    unsigned int firstPacket;
+    unsigned int count;
+};
+
+// Layout glMultiDrawElementsIndirect reads its draws in
+struct DrawElementsIndirectCommand {
+    unsigned int count;
+    unsigned int instanceCount;
+    unsigned int firstIndex;
+    unsigned int baseVertex;
+    unsigned int baseInstance;
+};
+
+// A run of batches sharing program and material, submitted with a single multi-draw
+struct MultiDrawGroup {
+    unsigned int firstBatch;
+    unsigned int count;
+};
+
+// Collects every draw of a frame, sorts them by state and submits them skipping redundant binds.
+// Consecutive draws of the same mesh become a single instanced draw, their model matrices written into the
+// frame's region of a FrameRingBuffer and read at INSTANCE_MATRIX_LOCATION.
+// On GL 4.3 contexts the queue can instead copy the meshes into a shared GeometryPool and submit all batches
+// sharing a program and material with one glMultiDrawElementsIndirect.
+// With a depth pre-pass program set, every draw first lays down depth alone, reading positions through the meshes'
+// depth VAOs, and the shaded pass then tests against it so hidden fragments are rejected before shading.
+// Its storage is kept between frames, so once it has grown to the scene's size recording allocates nothing
+class RenderQueue
+{
+public:
+    // state changes of the last flush
+    RenderStats Stats;
+    // draws are submitted in recording order when false, which is useful to measure what sorting saves
+    bool Sorting;
+    // use the multi-draw indirect path, ignored when the context is older than 4.3
+    bool MultiDraw;
+    // program drawing the depth pre-pass, which is skipped when null. It reads the position at location 0 and
+    // the instance matrix, and must compute gl_Position exactly as the shaded programs do (declare it invariant)
+    const Shader *DepthPrepass;
+
+    // frameData receives the instance matrices; its frames must begin before the first Flush and end after each one
+    RenderQueue(FrameRingBuffer &frameData) : Sorting(true), MultiDraw(false), DepthPrepass(nullptr), frameData(frameData), instanceOffset(0), indirectBuffer(0), indirectCapacity(0), farPlane(100.0f)
+    {
+        clearStats();
+    }
+
+    // starts a new frame; the view matrix and far plane are used to compute each draw's depth
+    void Begin(const glm::mat4 &view, float farPlane)
+    {
+        this->view = view;
+        this->farPlane = farPlane;
+        packets.clear();
+        matrices.clear();
+        programStamps.clear();
+    }
+
+    // records every mesh in meshes to be drawn with the given program and model matrix
+    void Submit(const Shader &shader, vector<Mesh> &meshes, const glm::mat4 &model)
+    {
+        unsigned int matrix = matrices.size();
+        matrices.push_back(model);
+        // all meshes of a model share its origin, so they share its depth too
+        uint64_t depth = modelDepth(model);
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            submitMesh(shader, meshes[i], matrix, depth);
+    }
+
+    // same, drawing each mesh with the permutation its material needs. Draws are always instanced,
+    // so that's part of every permutation asked for
+    void Submit(ShaderPermutations &shaders, vector<Mesh> &meshes, const glm::mat4 &model)
+    {
+        unsigned int matrix = matrices.size();
+        matrices.push_back(model);
+        uint64_t depth = modelDepth(model);
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            submitMesh(shaders.Get(meshes[i].shaderFeatures | SHADER_INSTANCED), meshes[i], matrix, depth);
+    }
+
+    // whether Flush will take the multi-draw indirect path
+    bool UsingMultiDraw() const
+    {
+        return MultiDraw && GLAD_GL_VERSION_4_3;
+    }
+
+    // sorts the recorded draws and issues them
+    void Flush()
+    {
+        if(Sorting)
+            std::sort(packets.begin(), packets.end());
+        clearStats();
+        buildBatches();
+        // nothing is assumed about the state left by whoever rendered before the queue
+        resetState();
+
+        if(UsingMultiDraw())
+        {
+            buildCommands();
+            if(DepthPrepass)
+                depthPrepassMultiDraw();
+            flushMultiDraw();
+        }
+        else
+        {
+            if(DepthPrepass)
+                depthPrepassPerMesh();
+            flushPerMesh();
+        }
+        if(DepthPrepass)
+        {
+            glDepthMask(GL_TRUE);
+            glDepthFunc(GL_LESS);
+            Stats.apiCalls += 2;
+        }
+
+        // always good practice to set everything back to defaults once configured.
+        glBindVertexArray(0);
+        glActiveTexture(GL_TEXTURE0);
+        Stats.apiCalls += 2;
+    }
+
+private:
+    uint64_t modelDepth(const glm::mat4 &model) const
+    {
+        glm::vec4 viewPosition = view * model[3];
+        return quantizeDepth(-viewPosition.z);
+    }
+
+    void submitMesh(const Shader &shader, Mesh &mesh, unsigned int matrix, uint64_t depth)
+    {
+        DrawPacket packet;
+        packet.key = ((uint64_t)(programIndex(shader) & 0xFF) << 56) |
+                     ((uint64_t)(mesh.materialKey & 0xFFFFF) << 36) |
+                     ((uint64_t)(mesh.VAO & 0xFFFFF) << 16) |
+                     depth;
+        packet.shader = &shader;
+        packet.mesh = &mesh;
+        packet.matrix = matrix;
+        packets.push_back(packet);
+    }
+
+    static const unsigned int MAX_TEXTURE_UNITS = 16;
+
+    vector<DrawPacket> packets;
+    vector<glm::mat4> matrices;     // in submission order, indexed by the packets
+    vector<DrawBatch> batches;
+    vector<unsigned int> programStamps;     // link stamps of the programs recorded this frame, by program index
+    FrameRingBuffer &frameData;
+    size_t instanceOffset;          // where this frame's matrices start in the ring buffer, in sorted order
+    // multi-draw indirect path
+    GeometryPool pool;
+    vector<DrawElementsIndirectCommand> commands;
+    vector<MultiDrawGroup> groups;
+    unsigned int indirectBuffer;
+    size_t indirectCapacity;
+    // state bound so far by the current flush
+    const Shader *currentShader;
+    unsigned int currentStamp;
+    unsigned int currentMaterial;
+    unsigned int currentVAO;
+    bool materialBound;
+    unsigned int boundTextures[MAX_TEXTURE_UNITS];
+    glm::mat4 view;
+    float farPlane;
+
+    // index of the program among those recorded this frame. Past 256 programs indices share the key field,
+    // which only costs some state changes, the batches still compare the programs themselves
+    unsigned int programIndex(const Shader &shader)
+    {
+        // draws tend to come in runs of the same program, so the search starts from the last one added
+        for(size_t i = programStamps.size(); i > 0; i--)
+            if(programStamps[i - 1] == shader.LinkStamp)
+                return i - 1;
+        programStamps.push_back(shader.LinkStamp);
+        return programStamps.size() - 1;
+    }
+
+    void resetState()
+    {
+        currentShader = nullptr;
+        currentStamp = 0;
+        currentMaterial = 0;
+        currentVAO = 0;
+        materialBound = false;
+        for(unsigned int i = 0; i < MAX_TEXTURE_UNITS; i++)
+            boundTextures[i] = 0;
+    }
+
+    // makes the program and textures of a packet current, skipping what already is
+    void bindProgramAndMaterial(const DrawPacket &packet)
+    {
+        Mesh &mesh = *packet.mesh;
+        if(packet.shader != currentShader)
+        {
+            if(!currentShader || packet.shader->ID != currentShader->ID)
+            {
+                glUseProgram(packet.shader->ID);
+                Stats.programChanges++;
+                Stats.apiCalls++;
+            }
+            currentShader = packet.shader;
+        }
+        // sampler locations differ between programs, so a new program means binding the material again
+        if(!materialBound || mesh.materialKey != currentMaterial || currentShader->LinkStamp != currentStamp)
+        {
+            const vector<TextureBinding> &bindings = mesh.GetBindings(*currentShader);
+            for(unsigned int t = 0; t < bindings.size(); t++)
+            {
+                if(bindings[t].sampler.set((int)bindings[t].unit))
+                    Stats.apiCalls++;
+                if(bindings[t].unit < MAX_TEXTURE_UNITS && boundTextures[bindings[t].unit] == bindings[t].id)
+                    continue;
+                glActiveTexture(GL_TEXTURE0 + bindings[t].unit);
+                glBindTexture(GL_TEXTURE_2D, bindings[t].id);
+                if(bindings[t].unit < MAX_TEXTURE_UNITS)
+                    boundTextures[bindings[t].unit] = bindings[t].id;
+                Stats.textureBinds++;
+                Stats.apiCalls += 2;
+            }
+            currentMaterial = mesh.materialKey;
+            currentStamp = currentShader->LinkStamp;
+            materialBound = true;
+            Stats.materialChanges++;
+        }
+    }
+
+    void bindVertexArray(unsigned int VAO)
+    {
+        if(VAO != currentVAO)
+        {
+            glBindVertexArray(VAO);
+            currentVAO = VAO;
+            Stats.vaoChanges++;
+            Stats.apiCalls++;
+        }
+    }
+
+    // GL 3.3 path: one instanced draw per batch, each mesh read through its own VAO
+    void flushPerMesh()
+    {
+        for(size_t i = 0; i < batches.size(); i++)
+        {
+            const DrawBatch &batch = batches[i];
+            const DrawPacket &packet = packets[batch.firstPacket];
+            bindProgramAndMaterial(packet);
+            bindVertexArray(packet.mesh->VAO);
+            // GL 3.3 has no base instance, so the instance attribute is pointed at the batch's first matrix instead
+            setInstanceAttributes(instanceOffset + batch.firstPacket * sizeof(glm::mat4));
+            glDrawElementsInstanced(GL_TRIANGLES, packet.mesh->indices.size(), packet.mesh->indexType, 0, batch.count);
+            Stats.drawCalls++;
+            Stats.instances += batch.count;
+            Stats.apiCalls++;
+        }
+    }
+
+    // depth pre-pass: depth only, no color, the program bound once for every draw
+    void beginDepthPrepass()
+    {
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glUseProgram(DepthPrepass->ID);
+        currentShader = DepthPrepass;
+        Stats.programChanges++;
+        Stats.apiCalls += 2;
+    }
+
+    // the shaded pass keeps the depth as laid down, and passes only the fragments matching it
+    void endDepthPrepass()
+    {
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_LEQUAL);
+        Stats.apiCalls += 3;
+    }
+
+    void depthPrepassPerMesh()
+    {
+        beginDepthPrepass();
+        for(size_t i = 0; i < batches.size(); i++)
+        {
+            const DrawBatch &batch = batches[i];
+            const Mesh &mesh = *packets[batch.firstPacket].mesh;
+            bindVertexArray(mesh.depthVAO);
+            setInstanceAttributes(instanceOffset + batch.firstPacket * sizeof(glm::mat4));
+            glDrawElementsInstanced(GL_TRIANGLES, mesh.indices.size(), mesh.indexType, 0, batch.count);
+            Stats.drawCalls++;
+            Stats.apiCalls++;
+        }
+        endDepthPrepass();
+    }
+
+    // every command reads the pool's positions, so the whole pre-pass is one multi-draw
+    void depthPrepassMultiDraw()
+    {
+        beginDepthPrepass();
+        bindVertexArray(pool.depthVAO);
+        if(!commands.empty())
+        {
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, 0, commands.size(), 0);
+            Stats.drawCalls++;
+            Stats.apiCalls++;
+        }
+        endDepthPrepass();
+    }
+
+    // GL 4.3 path: every batch becomes an indirect command reading the shared pool, and batches sharing
+    // program and material are submitted together. The base instance of each command selects its matrices.
+    // Leaves the indirect buffer bound for the draws
+    void buildCommands()
+    {
+        if(!pool.IsSetup())
+            pool.Setup(INSTANCE_MATRIX_LOCATION);
+        commands.clear();
+        groups.clear();
+        for(size_t i = 0; i < batches.size(); i++)
+        {
+            const DrawBatch &batch = batches[i];
+            const DrawPacket &packet = packets[batch.firstPacket];
+            Mesh &mesh = *packet.mesh;
+            pool.Add(mesh);
+
+            DrawElementsIndirectCommand command;
+            command.count = mesh.indices.size();
+            command.instanceCount = batch.count;
+            command.firstIndex = mesh.poolFirstIndex;
+            command.baseVertex = mesh.poolBaseVertex;
+            command.baseInstance = batch.firstPacket;
+            commands.push_back(command);
+
+            if(!groups.empty())
+            {
+                const DrawPacket &first = packets[batches[groups.back().firstBatch].firstPacket];
+                if(first.shader == packet.shader && first.mesh->materialKey == mesh.materialKey)
+                {
+                    groups.back().count++;
+                    continue;
+                }
+            }
+            MultiDrawGroup group;
+            group.firstBatch = i;
+            group.count = 1;
+            groups.push_back(group);
+        }
+
+        if(!indirectBuffer)
+            glGenBuffers(1, &indirectBuffer);
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirectBuffer);
+        size_t size = commands.size() * sizeof(DrawElementsIndirectCommand);
+        if(size > indirectCapacity)
+            indirectCapacity = size;
+        glBufferData(GL_DRAW_INDIRECT_BUFFER, indirectCapacity, NULL, GL_STREAM_DRAW);
+        if(size > 0)
+            glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, size, &commands[0]);
+        Stats.apiCalls += 3;
+
+        // the frame's matrices move around the ring buffer, so the pool's attribute follows them
+        pool.SetInstanceSource(frameData.Buffer(), instanceOffset);
+    }
+
+    void flushMultiDraw()
+    {
+        bindVertexArray(pool.VAO);
+        for(size_t i = 0; i < groups.size(); i++)
+        {
+            const MultiDrawGroup &group = groups[i];
+            bindProgramAndMaterial(packets[batches[group.firstBatch].firstPacket]);
+            glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (void*)(group.firstBatch * sizeof(DrawElementsIndirectCommand)), group.count, 0);
+            Stats.drawCalls++;
+            Stats.apiCalls++;
+            for(unsigned int b = 0; b < group.count; b++)
+                Stats.instances += batches[group.firstBatch + b].count;
+        }
+        glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+        Stats.apiCalls++;
+    }
+
+    // splits the sorted packets into runs of the same mesh and program, and writes their matrices in that order
+    // straight into the ring buffer
+    void buildBatches()
+    {
+        batches.clear();
+        glm::mat4 *instanceMatrices = (glm::mat4*)frameData.Allocate(packets.size() * sizeof(glm::mat4), instanceOffset);
+        for(size_t i = 0; i < packets.size(); i++)
+        {
+            instanceMatrices[i] = matrices[packets[i].matrix];
+            if(!batches.empty())
+            {
+                const DrawPacket &first = packets[batches.back().firstPacket];
+                if(first.mesh == packets[i].mesh && first.shader == packets[i].shader)
+                {
+                    batches.back().count++;
+                    continue;
+                }
+            }
+            DrawBatch batch;
+            batch.firstPacket = i;
+            batch.count = 1;
+            batches.push_back(batch);
+        }
+        frameData.Flush();
+        Stats.apiCalls += frameData.IsPersistent() ? 0 : 2;
+    }
+
+    // points the four columns of the instance matrix attribute of the bound VAO at the given offset of the instance buffer
+    void setInstanceAttributes(size_t offset)
+    {
+        glBindBuffer(GL_ARRAY_BUFFER, frameData.Buffer());
+        for(unsigned int c = 0; c < 4; c++)
+        {
+            glEnableVertexAttribArray(INSTANCE_MATRIX_LOCATION + c);
+            glVertexAttribPointer(INSTANCE_MATRIX_LOCATION + c, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(offset + c * sizeof(glm::vec4)));
+            glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION + c, 1);
+        }
+        Stats.apiCalls += 13;
+    }
+
+    void clearStats()
+    {
+        Stats.apiCalls = 0;
+        Stats.drawCalls = 0;
+        Stats.instances = 0;
+        Stats.programChanges = 0;
+        Stats.materialChanges = 0;
+        Stats.vaoChanges = 0;
+        Stats.textureBinds = 0;
+    }
+
+    // maps a view space distance to 16 bits, nearest first
+    uint64_t quantizeDepth(float distance) const
+    {
+        float d = distance / farPlane;
+        if(d < 0.0f)
+            d = 0.0f;
+        if(d > 1.0f)
+            d = 1.0f;
+        return (uint64_t)(d * 65535.0f);
+    }
+};
+#endif
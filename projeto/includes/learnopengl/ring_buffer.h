@@ -0,0 +1,176 @@
+#ifndef RING_BUFFER_H
+#define RING_BUFFER_H
+
+#include <glad/glad.h>
+
+#include <cstddef>
+#include <cstring>
+#include <vector>
+
+// Streams the data that changes every frame (instance matrices, per draw parameters...) to the GPU.
+//
+// On GL 4.4 the buffer is created with glBufferStorage and mapped once, persistently, split in FRAMES regions
+// used in turn. A fence is placed after each frame's draws and waited on only when that region comes around
+// again, so the CPU writes straight into memory the GPU isn't reading and the driver never stalls on the buffer.
+// Older contexts fall back to orphaning: writes go to a CPU copy that Flush uploads into storage the buffer
+// was given at the start of the frame.
+//
+// Data is bound by offset (glVertexAttribPointer, glBindBufferRange...) into Buffer(). When a frame needs more
+// room than a region has, the buffer is recreated bigger, which invalidates the offsets handed out earlier in that
+// frame; so allocate everything a frame needs before binding any of it
+class FrameRingBuffer
+{
+public:
+    static const unsigned int FRAMES = 3;
+
+    FrameRingBuffer(size_t regionSize = 1 << 20) : buffer(0), mapped(nullptr), persistent(false), regionSize(regionSize), frame(0), used(0), uploaded(0)
+    {
+        for(unsigned int i = 0; i < FRAMES; i++)
+            fences[i] = 0;
+    }
+
+    // the buffer to bind; it changes when the ring grows
+    unsigned int Buffer() const
+    {
+        return buffer;
+    }
+
+    // whether writes go straight to persistently mapped memory
+    bool IsPersistent() const
+    {
+        return persistent;
+    }
+
+    // starts writing the next frame's region, waiting for the GPU if it is still reading it
+    void BeginFrame()
+    {
+        if(!buffer)
+            create(regionSize);
+        frame = (frame + 1) % FRAMES;
+        used = 0;
+        uploaded = 0;
+        if(persistent)
+            waitFence(frame);
+        else
+        {
+            // orphan: the storage the GPU may still be reading is kept alive by the driver, we get new one
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, regionSize, NULL, GL_STREAM_DRAW);
+        }
+    }
+
+    // reserves size bytes of this frame's region and returns where to write them; offset receives their
+    // position in Buffer(). alignment must be a power of two (GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT for uniform blocks)
+    void* Allocate(size_t size, size_t &offset, size_t alignment = 16)
+    {
+        size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if(start + size > regionSize)
+        {
+            size_t newSize = regionSize * 2;
+            while(newSize < start + size)
+                newSize *= 2;
+            grow(newSize);
+            start = 0;
+        }
+        used = start + size;
+        offset = regionStart() + start;
+        if(persistent)
+            return mapped + offset;
+        return &staging[start];
+    }
+
+    // makes everything allocated so far visible to the GPU. Persistent mappings are coherent so there's nothing to do,
+    // the fallback uploads what was written since the last call
+    void Flush()
+    {
+        if(persistent || used == uploaded)
+            return;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, uploaded, used - uploaded, &staging[uploaded]);
+        uploaded = used;
+    }
+
+    // called once the frame's draws are submitted, fences the region so it isn't overwritten while in use
+    void EndFrame()
+    {
+        Flush();
+        if(!persistent)
+            return;
+        if(fences[frame])
+            glDeleteSync(fences[frame]);
+        fences[frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    }
+
+private:
+    unsigned int buffer;
+    char *mapped;
+    bool persistent;
+    size_t regionSize;
+    unsigned int frame;
+    size_t used, uploaded;      // bytes of the current region allocated, and already sent in the fallback
+    GLsync fences[FRAMES];
+    std::vector<char> staging;  // fallback only
+
+    size_t regionStart() const
+    {
+        return persistent ? frame * regionSize : 0;
+    }
+
+    void create(size_t size)
+    {
+        regionSize = size;
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        persistent = false;
+        if(GLAD_GL_VERSION_4_4)
+        {
+            GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+            glBufferStorage(GL_COPY_WRITE_BUFFER, FRAMES * regionSize, NULL, flags);
+            mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, FRAMES * regionSize, flags);
+            if(mapped)
+            {
+                persistent = true;
+                return;
+            }
+            // immutable storage can't be respecified, so the fallback needs a buffer of its own
+            glDeleteBuffers(1, &buffer);
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+        }
+        glBufferData(GL_COPY_WRITE_BUFFER, regionSize, NULL, GL_STREAM_DRAW);
+        staging.resize(regionSize);
+    }
+
+    // replaces the buffer with a bigger one; the GPU keeps the old storage alive for as long as it reads it
+    void grow(size_t size)
+    {
+        for(unsigned int i = 0; i < FRAMES; i++)
+        {
+            if(fences[i])
+                glDeleteSync(fences[i]);
+            fences[i] = 0;
+        }
+        if(persistent)
+        {
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        }
+        glDeleteBuffers(1, &buffer);
+        mapped = nullptr;
+        create(size);
+        used = 0;
+        uploaded = 0;
+    }
+
+    void waitFence(unsigned int region)
+    {
+        if(!fences[region])
+            return;
+        GLenum result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        while(result == GL_TIMEOUT_EXPIRED)
+            result = glClientWaitSync(fences[region], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        glDeleteSync(fences[region]);
+        fences[region] = 0;
+    }
+};
+#endif
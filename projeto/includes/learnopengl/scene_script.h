@@ -0,0 +1,159 @@
+#ifndef SCENE_SCRIPT_H
+#define SCENE_SCRIPT_H
+
+#include <glm/glm.hpp>
+
+#include <learnopengl/filesystem.h>
+#include <learnopengl/importer.h>
+#include <learnopengl/model.h>
+
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Scatters count copies of rock on a ring around the origin. They share the rock's asset, so the whole field is
+// drawn with one instanced draw per mesh. The same seed always gives the same field
+inline void AddAsteroidField(vector<Model> &models, const Model &rock, unsigned int count, unsigned int seed)
+{
+    std::minstd_rand random(seed);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    models.reserve(models.size() + count);
+    for(unsigned int i = 0; i < count; i++)
+    {
+        float angle = unit(random) * glm::radians(360.0f);
+        float radius = 40.0f + (unit(random) - 0.5f) * 10.0f;
+        float height = (unit(random) - 0.5f) * 4.0f;
+        float size = 0.05f + unit(random) * 0.2f;
+        models.push_back(rock);
+        models.back().Translate(glm::vec3(sin(angle) * radius, height, cos(angle) * radius), 0);
+        models.back().Scale(glm::vec3(size), 0);
+    }
+}
+
+// A scene to benchmark, read from a text file with one command per line ('#' starts a comment):
+//   frames <count>                         frames to render, 300 by default
+//   timestep <seconds>                     simulated time between frames, 1/60 by default
+//   camera <x> <y> <z> [<yaw> <pitch>]     where the camera is, in degrees like Camera
+//   profile fast|full|collision            import profile of the models loaded after it
+//   model <path>                           loads a model, path relative to the project root
+//   translate <x> <y> <z> <seconds>        the transforms apply to the last model loaded
+//   scale <x> <y> <z> <seconds>
+//   rotate <degrees> <x> <y> <z> <seconds> around the axis
+//   asteroids <path> <count> [<seed>]      a field of count copies of the model
+//   dump <frame>                           saves the frame as an image
+// Time only advances by the timestep, so every run of a script renders the same frames
+struct SceneScript {
+    unsigned int frames;
+    float timestep;
+    bool hasCamera;
+    glm::vec3 cameraPosition;
+    float yaw, pitch;
+    vector<unsigned int> dumpFrames;
+
+    SceneScript() : frames(300), timestep(1.0f / 60.0f), hasCamera(false), cameraPosition(0.0f, 0.0f, 3.0f), yaw(-90.0f), pitch(0.0f) {}
+};
+
+// Reads the script at path and loads its models into models. Returns false, after printing where, on the first
+// line it can't understand
+inline bool LoadSceneScript(const std::string &path, SceneScript &script, vector<Model> &models)
+{
+    std::ifstream file(path.c_str());
+    if(!file)
+    {
+        printf("Could not open scene %s\n", path.c_str());
+        return false;
+    }
+    Import_Profile profile = IMPORT_FULL_QUALITY;
+    std::string line;
+    unsigned int lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if(comment != std::string::npos)
+            line.erase(comment);
+        std::istringstream in(line);
+        std::string command;
+        if(!(in >> command))
+            continue;
+
+        bool ok = true;
+        glm::vec3 v;
+        float seconds, angle;
+        if(command == "frames")
+            ok = !!(in >> script.frames);
+        else if(command == "timestep")
+            ok = !!(in >> script.timestep);
+        else if(command == "camera")
+        {
+            ok = !!(in >> script.cameraPosition.x >> script.cameraPosition.y >> script.cameraPosition.z);
+            if(in >> script.yaw)
+                ok = ok && !!(in >> script.pitch);
+            script.hasCamera = true;
+        }
+        else if(command == "profile")
+        {
+            std::string name;
+            in >> name;
+            if(name == "fast")
+                profile = IMPORT_FAST_PREVIEW;
+            else if(name == "full")
+                profile = IMPORT_FULL_QUALITY;
+            else if(name == "collision")
+                profile = IMPORT_COLLISION_ONLY;
+            else
+                ok = false;
+        }
+        else if(command == "model")
+        {
+            std::string model;
+            ok = !!(in >> model);
+            if(ok)
+                models.push_back(Model(FileSystem::getPath(model), false, profile));
+        }
+        else if(command == "asteroids")
+        {
+            std::string model;
+            unsigned int count, seed = 0;
+            ok = !!(in >> model >> count);
+            in >> seed;
+            if(ok)
+                AddAsteroidField(models, Model(FileSystem::getPath(model), false, profile), count, seed);
+        }
+        else if(command == "translate" || command == "scale")
+        {
+            ok = !models.empty() && (in >> v.x >> v.y >> v.z >> seconds);
+            if(ok && command == "translate")
+                models.back().Translate(v, seconds);
+            else if(ok)
+                models.back().Scale(v, seconds);
+        }
+        else if(command == "rotate")
+        {
+            ok = !models.empty() && (in >> angle >> v.x >> v.y >> v.z >> seconds);
+            if(ok)
+                models.back().RotateAx(glm::radians(angle), seconds, v);
+        }
+        else if(command == "dump")
+        {
+            unsigned int frame;
+            ok = !!(in >> frame);
+            if(ok)
+                script.dumpFrames.push_back(frame);
+        }
+        else
+            ok = false;
+
+        if(!ok)
+        {
+            printf("%s:%u: can't understand \"%s\"\n", path.c_str(), lineNumber, line.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+#endif
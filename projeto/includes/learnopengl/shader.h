@@ -4,99 +4,373 @@
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 
+#include <algorithm>
 #include <string>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
 #include <fstream>
-#include <sstream>
+#include <iterator>
 #include <iostream>
+#include <cstring>
+#include <memory>
+#include <deque>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
-class Shader
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+// An active uniform of a linked program together with the last value uploaded to it, so setting the same
+// value twice doesn't reach the driver. Values written with glUniform* directly bypass this cache
+struct UniformSlot {
+    GLint location;
+    GLenum type;
+    bool valid;         // whether value holds what the program currently has
+    GLfloat value[16];  // large enough for a mat4, ints are stored bit for bit
+};
+
+// Pre-resolved handle to a uniform of a program. Setting through a handle costs no lookup at all;
+// like the glUniform* calls it wraps, it applies to the program currently in use.
+// Handles stay valid for the lifetime of the program they were taken from. A set returns whether the value had to
+// be uploaded
+class Uniform
 {
 public:
-    unsigned int ID;
-    // constructor generates the shader on the fly
-    // ------------------------------------------------------------------------
-    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+    Uniform(UniformSlot *slot = nullptr) : slot(slot) {}
+
+    bool isValid() const { return slot != nullptr && slot->location != -1; }
+
+    bool set(bool value) const          { return set((int)value); }
+    bool set(int value) const
+    {
+        if(!changed(&value, sizeof(int)))
+            return false;
+        glUniform1i(slot->location, value);
+        return true;
+    }
+    bool set(float value) const
+    {
+        if(!changed(&value, sizeof(float)))
+            return false;
+        glUniform1f(slot->location, value);
+        return true;
+    }
+    bool set(const glm::vec2 &value) const
+    {
+        if(!changed(&value[0], sizeof(glm::vec2)))
+            return false;
+        glUniform2fv(slot->location, 1, &value[0]);
+        return true;
+    }
+    bool set(const glm::vec3 &value) const
+    {
+        if(!changed(&value[0], sizeof(glm::vec3)))
+            return false;
+        glUniform3fv(slot->location, 1, &value[0]);
+        return true;
+    }
+    bool set(const glm::vec4 &value) const
+    {
+        if(!changed(&value[0], sizeof(glm::vec4)))
+            return false;
+        glUniform4fv(slot->location, 1, &value[0]);
+        return true;
+    }
+    bool set(const glm::mat2 &mat) const
     {
-        // 1. retrieve the vertex/fragment source code from filePath
-        std::string vertexCode;
-        std::string fragmentCode;
-        std::string geometryCode;
-        std::ifstream vShaderFile;
-        std::ifstream fShaderFile;
-        std::ifstream gShaderFile;
-        // ensure ifstream objects can throw exceptions:
-        vShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        fShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        gShaderFile.exceptions (std::ifstream::failbit | std::ifstream::badbit);
-        try 
-        {
-            // open files
-            vShaderFile.open(vertexPath);
-            fShaderFile.open(fragmentPath);
-            std::stringstream vShaderStream, fShaderStream;
-            // read file's buffer contents into streams
-            vShaderStream << vShaderFile.rdbuf();
-            fShaderStream << fShaderFile.rdbuf();		
-            // close file handlers
-            vShaderFile.close();
-            fShaderFile.close();
-            // convert stream into string
-            vertexCode = vShaderStream.str();
-            fragmentCode = fShaderStream.str();			
-            // if geometry shader path is present, also load a geometry shader
-            if(geometryPath != nullptr)
+        if(!changed(&mat[0][0], sizeof(glm::mat2)))
+            return false;
+        glUniformMatrix2fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+        return true;
+    }
+    bool set(const glm::mat3 &mat) const
+    {
+        if(!changed(&mat[0][0], sizeof(glm::mat3)))
+            return false;
+        glUniformMatrix3fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+        return true;
+    }
+    bool set(const glm::mat4 &mat) const
+    {
+        if(!changed(&mat[0][0], sizeof(glm::mat4)))
+            return false;
+        glUniformMatrix4fv(slot->location, 1, GL_FALSE, &mat[0][0]);
+        return true;
+    }
+
+private:
+    UniformSlot *slot;
+
+    // stores the value and tells whether it has to be uploaded; unknown uniforms never are
+    bool changed(const void *data, size_t size) const
+    {
+        if(!isValid())
+            return false;
+        if(slot->valid && memcmp(slot->value, data, size) == 0)
+            return false;
+        memcpy(slot->value, data, size);
+        slot->valid = true;
+        return true;
+    }
+};
+
+// Uniform blocks shared by every program (like the camera block), by name, with the binding point each is
+// read from. Programs linked after a block is registered here are bound to it automatically
+inline std::map<std::string, GLuint>& SharedUniformBlocks()
+{
+    static std::map<std::string, GLuint> blocks;
+    return blocks;
+}
+
+// Directory compiled programs are cached in, keyed by a hash of their sources and the driver. Empty disables the cache
+inline std::string& ShaderCacheDirectory()
+{
+    static std::string directory;
+    return directory;
+}
+
+// Preprocessor defines to build a shader with, name to value (the value may be empty)
+typedef std::map<std::string, std::string> ShaderDefines;
+
+// Features a material can ask of a shader. Each one is a define of the same name that the shader
+// tests with #ifdef; a shader ignoring a feature gets the same source, and program, with or without it
+enum Shader_Feature {
+    SHADER_DIFFUSE_MAP  = 1 << 0,
+    SHADER_NORMAL_MAP   = 1 << 1,
+    SHADER_SPECULAR_MAP = 1 << 2,
+    SHADER_INSTANCED    = 1 << 3
+};
+const unsigned int SHADER_FEATURE_COUNT = 4;
+
+inline const char* ShaderFeatureName(unsigned int bit)
+{
+    static const char *names[SHADER_FEATURE_COUNT] = {"SHADER_DIFFUSE_MAP", "SHADER_NORMAL_MAP", "SHADER_SPECULAR_MAP", "SHADER_INSTANCED"};
+    return bit < SHADER_FEATURE_COUNT ? names[bit] : "";
+}
+
+// Adds the define of every feature set in features
+inline void AddFeatureDefines(unsigned int features, ShaderDefines &defines)
+{
+    for(unsigned int bit = 0; bit < SHADER_FEATURE_COUNT; bit++)
+        if(features & (1u << bit))
+            defines[ShaderFeatureName(bit)] = "1";
+}
+
+// The preprocessed source of every stage of a program; geometry is empty when there's no geometry stage
+struct ShaderSources {
+    std::string vertex;
+    std::string fragment;
+    std::string geometry;
+};
+
+// 64-bit FNV-1a, continuing from hash
+inline uint64_t HashShaderText(const std::string &text, uint64_t hash = 14695981039346656037ULL)
+{
+    for(size_t i = 0; i < text.size(); i++)
+    {
+        hash ^= (unsigned char)text[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+inline uint64_t HashShaderSources(const ShaderSources &sources)
+{
+    uint64_t hash = HashShaderText(sources.vertex);
+    hash = HashShaderText(sources.fragment, hash);
+    return HashShaderText(sources.geometry, hash);
+}
+
+// pastes the file into source, replacing its #include "file" lines (relative to the including file) with the
+// files they name. Each file is pasted once, so includes need no guards and can't recurse
+inline bool preprocessShaderFile(const std::string &path, std::vector<std::string> &included, std::string &source)
+{
+    for(size_t i = 0; i < included.size(); i++)
+        if(included[i] == path)
+            return true;
+    included.push_back(path);
+    std::ifstream file(path.c_str());
+    if(!file)
+    {
+        std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ: " << path << std::endl;
+        return false;
+    }
+    std::string directory;
+    size_t slash = path.find_last_of("/\\");
+    if(slash != std::string::npos)
+        directory = path.substr(0, slash + 1);
+    bool ok = true;
+    std::string line;
+    unsigned int lineNumber = 0;
+    while(std::getline(file, line))
+    {
+        lineNumber++;
+        size_t start = line.find_first_not_of(" \t");
+        if(start != std::string::npos && line.compare(start, 8, "#include") == 0)
+        {
+            size_t open = line.find('"', start + 8);
+            size_t close = open == std::string::npos ? open : line.find('"', open + 1);
+            if(close == std::string::npos)
             {
-                gShaderFile.open(geometryPath);
-                std::stringstream gShaderStream;
-                gShaderStream << gShaderFile.rdbuf();
-                gShaderFile.close();
-                geometryCode = gShaderStream.str();
+                std::cout << "ERROR::SHADER::BAD_INCLUDE: " << path << ":" << lineNumber << std::endl;
+                ok = false;
+                continue;
             }
+            ok = preprocessShaderFile(directory + line.substr(open + 1, close - open - 1), included, source) && ok;
+            // keeps compiler messages pointing at the right line of this file
+            source += "#line " + std::to_string(lineNumber + 1) + "\n";
+            continue;
         }
-        catch (std::ifstream::failure e)
+        source += line;
+        source += '\n';
+    }
+    return ok;
+}
+
+// the identifiers a define can reach in source, whole words outside comments: those tested by #if, #ifdef,
+// #ifndef and #elif (defined(NAME) included), and those in the code, where a define with a value may be used.
+// Other directives (#version, #extension, #define...) are skipped
+inline std::set<std::string> shaderIdentifiers(const std::string &source)
+{
+    std::set<std::string> identifiers;
+    bool blockComment = false, directive = false, skipLine = false, lineStart = true;
+    for(size_t i = 0; i < source.size();)
+    {
+        char c = source[i];
+        if(blockComment)
         {
-            std::cout << "ERROR::SHADER::FILE_NOT_SUCCESFULLY_READ" << std::endl;
+            if(source.compare(i, 2, "*/") == 0)
+            {
+                blockComment = false;
+                i += 2;
+            }
+            else
+                i++;
+            continue;
         }
-        const char* vShaderCode = vertexCode.c_str();
-        const char * fShaderCode = fragmentCode.c_str();
-        // 2. compile shaders
-        unsigned int vertex, fragment;
-        int success;
-        char infoLog[512];
-        // vertex shader
-        vertex = glCreateShader(GL_VERTEX_SHADER);
-        glShaderSource(vertex, 1, &vShaderCode, NULL);
-        glCompileShader(vertex);
-        checkCompileErrors(vertex, "VERTEX");
-        // fragment Shader
-        fragment = glCreateShader(GL_FRAGMENT_SHADER);
-        glShaderSource(fragment, 1, &fShaderCode, NULL);
-        glCompileShader(fragment);
-        checkCompileErrors(fragment, "FRAGMENT");
-        // if geometry shader is given, compile geometry shader
-        unsigned int geometry;
-        if(geometryPath != nullptr)
+        if(c == '\n')
         {
-            const char * gShaderCode = geometryCode.c_str();
-            geometry = glCreateShader(GL_GEOMETRY_SHADER);
-            glShaderSource(geometry, 1, &gShaderCode, NULL);
-            glCompileShader(geometry);
-            checkCompileErrors(geometry, "GEOMETRY");
+            directive = skipLine = false;
+            lineStart = true;
+            i++;
+            continue;
         }
-        // shader Program
-        ID = glCreateProgram();
-        glAttachShader(ID, vertex);
-        glAttachShader(ID, fragment);
-        if(geometryPath != nullptr)
-            glAttachShader(ID, geometry);
-        glLinkProgram(ID);
-        checkCompileErrors(ID, "PROGRAM");
-        // delete the shaders as they're linked into our program now and no longer necessery
-        glDeleteShader(vertex);
-        glDeleteShader(fragment);
-        if(geometryPath != nullptr)
-            glDeleteShader(geometry);
+        if(source.compare(i, 2, "//") == 0)
+        {
+            i = source.find('\n', i);
+            if(i == std::string::npos)
+                break;
+            continue;
+        }
+        if(source.compare(i, 2, "/*") == 0)
+        {
+            blockComment = true;
+            i += 2;
+            continue;
+        }
+        if(c == ' ' || c == '\t' || c == '\r')
+        {
+            i++;
+            continue;
+        }
+        if(c == '#' && lineStart)
+        {
+            directive = true;
+            lineStart = false;
+            i++;
+            continue;
+        }
+        if(isalpha((unsigned char)c) || c == '_')
+        {
+            size_t end = i;
+            while(end < source.size() && (isalnum((unsigned char)source[end]) || source[end] == '_'))
+                end++;
+            std::string word = source.substr(i, end - i);
+            i = end;
+            if(directive)
+            {
+                // the first word of a directive says which one it is
+                directive = false;
+                skipLine = word != "if" && word != "ifdef" && word != "ifndef" && word != "elif";
+            }
+            else if(!skipLine)
+                identifiers.insert(word);
+        }
+        else
+            i++;
+        lineStart = false;
+    }
+    return identifiers;
+}
 
+// Reads a shader file, resolves its includes and puts the defines right after its #version line. Defines the
+// source never uses are left out, so permutations differing only by features a shader ignores come out identical
+inline std::string PreprocessShader(const std::string &path, const ShaderDefines &defines)
+{
+    std::vector<std::string> included;
+    std::string source;
+    preprocessShaderFile(path, included, source);
+    std::set<std::string> identifiers = shaderIdentifiers(source);
+    std::string header;
+    for(ShaderDefines::const_iterator it = defines.begin(); it != defines.end(); it++)
+        if(identifiers.count(it->first))
+            header += "#define " + it->first + " " + it->second + "\n";
+    if(header.empty())
+        return source;
+    // #version has to come first; without one the defines simply lead
+    size_t version = source.find("#version");
+    size_t insert = 0;
+    if(version != std::string::npos)
+    {
+        size_t end = source.find('\n', version);
+        insert = end == std::string::npos ? source.size() : end + 1;
+        header += "#line " + std::to_string(std::count(source.begin(), source.begin() + insert, '\n') + 1) + "\n";
+    }
+    return source.insert(insert, header);
+}
+
+inline ShaderSources LoadShaderSources(const char* vertexPath, const char* fragmentPath, const ShaderDefines &defines, const char* geometryPath = nullptr)
+{
+    ShaderSources sources;
+    sources.vertex = PreprocessShader(vertexPath, defines);
+    sources.fragment = PreprocessShader(fragmentPath, defines);
+    if(geometryPath != nullptr)
+        sources.geometry = PreprocessShader(geometryPath, defines);
+    return sources;
+}
+
+class Shader
+{
+public:
+    unsigned int ID;
+    // unique for every successful link, so objects caching per-program state (like a mesh's material bindings)
+    // can tell when the program they resolved against has been relinked or replaced
+    unsigned int LinkStamp;
+    // whether the program came from the binary cache instead of being compiled
+    bool LoadedFromCache;
+    // constructor generates the shader on the fly
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const char* geometryPath = nullptr)
+        : Shader(LoadShaderSources(vertexPath, fragmentPath, ShaderDefines(), geometryPath))
+    {
+    }
+    // same, with the given preprocessor defines
+    // ------------------------------------------------------------------------
+    Shader(const char* vertexPath, const char* fragmentPath, const ShaderDefines &defines, const char* geometryPath = nullptr)
+        : Shader(LoadShaderSources(vertexPath, fragmentPath, defines, geometryPath))
+    {
+    }
+    // builds the program from already preprocessed sources, from the binary cache when it holds this exact program
+    // ------------------------------------------------------------------------
+    explicit Shader(const ShaderSources &sources)
+    {
+        build(sources);
     }
     // activate the shader
     // ------------------------------------------------------------------------
@@ -104,66 +378,277 @@ public:
     { 
         glUseProgram(ID); 
     }
-    // utility uniform functions
+    // binds every shared uniform block the program uses to its binding point
+    // ------------------------------------------------------------------------
+    void BindSharedBlocks() const
+    {
+        std::map<std::string, GLuint>::const_iterator it;
+        for(it = SharedUniformBlocks().begin(); it != SharedUniformBlocks().end(); it++)
+        {
+            GLuint index = glGetUniformBlockIndex(ID, it->first.c_str());
+            if(index != GL_INVALID_INDEX)
+                glUniformBlockBinding(ID, index, it->second);
+        }
+    }
+    // returns a handle to the named uniform, which is invalid (and ignores every set) when the program has no such uniform.
+    // Names the reflection didn't list, like array elements past the first, are asked to the driver once and remembered
+    // ------------------------------------------------------------------------
+    Uniform getUniform(const std::string &name) const
+    {
+        std::unordered_map<std::string, size_t>::const_iterator it = uniforms->names.find(name);
+        if(it != uniforms->names.end())
+            return Uniform(&uniforms->slots[it->second]);
+        UniformSlot slot;
+        slot.location = glGetUniformLocation(ID, name.c_str());
+        slot.type = GL_NONE;
+        slot.valid = false;
+        uniforms->names[name] = uniforms->slots.size();
+        uniforms->slots.push_back(slot);
+        return Uniform(&uniforms->slots.back());
+    }
+    // utility uniform functions, looking the name up in the table built after linking
     // ------------------------------------------------------------------------
     void setBool(const std::string &name, bool value) const
     {         
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value); 
+        getUniform(name).set(value);
     }
     // ------------------------------------------------------------------------
     void setInt(const std::string &name, int value) const
     { 
-        glUniform1i(glGetUniformLocation(ID, name.c_str()), value); 
+        getUniform(name).set(value);
     }
     // ------------------------------------------------------------------------
     void setFloat(const std::string &name, float value) const
     { 
-        glUniform1f(glGetUniformLocation(ID, name.c_str()), value); 
+        getUniform(name).set(value);
     }
     // ------------------------------------------------------------------------
     void setVec2(const std::string &name, const glm::vec2 &value) const
     { 
-        glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        getUniform(name).set(value);
     }
     void setVec2(const std::string &name, float x, float y) const
     { 
-        glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y); 
+        getUniform(name).set(glm::vec2(x, y));
     }
     // ------------------------------------------------------------------------
     void setVec3(const std::string &name, const glm::vec3 &value) const
     { 
-        glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        getUniform(name).set(value);
     }
     void setVec3(const std::string &name, float x, float y, float z) const
     { 
-        glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z); 
+        getUniform(name).set(glm::vec3(x, y, z));
     }
     // ------------------------------------------------------------------------
     void setVec4(const std::string &name, const glm::vec4 &value) const
     { 
-        glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]); 
+        getUniform(name).set(value);
     }
-    void setVec4(const std::string &name, float x, float y, float z, float w) 
+    void setVec4(const std::string &name, float x, float y, float z, float w) const
     { 
-        glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w); 
+        getUniform(name).set(glm::vec4(x, y, z, w));
     }
     // ------------------------------------------------------------------------
     void setMat2(const std::string &name, const glm::mat2 &mat) const
     {
-        glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        getUniform(name).set(mat);
     }
     // ------------------------------------------------------------------------
     void setMat3(const std::string &name, const glm::mat3 &mat) const
     {
-        glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        getUniform(name).set(mat);
     }
     // ------------------------------------------------------------------------
     void setMat4(const std::string &name, const glm::mat4 &mat) const
     {
-        glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+        getUniform(name).set(mat);
     }
 
 private:
+    // compiles and links the sources, or loads the program binary cached for them by an earlier run
+    // ------------------------------------------------------------------------
+    void build(const ShaderSources &sources)
+    {
+        const std::string *geometryCode = sources.geometry.empty() ? nullptr : &sources.geometry;
+        // the key covers everything the binary depends on: the sources and the driver that compiled them
+        std::string cachePath;
+        if(!ShaderCacheDirectory().empty() && binaryCacheSupported())
+        {
+            uint64_t hash = HashShaderSources(sources);
+            hash = HashShaderText(glString(GL_VENDOR), hash);
+            hash = HashShaderText(glString(GL_RENDERER), hash);
+            hash = HashShaderText(glString(GL_VERSION), hash);
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+            cachePath = ShaderCacheDirectory() + "/" + name;
+        }
+        LoadedFromCache = !cachePath.empty() && loadBinary(cachePath);
+        if(!LoadedFromCache)
+        {
+            compile(sources.vertex, sources.fragment, geometryCode, !cachePath.empty());
+            if(!cachePath.empty())
+                saveBinary(cachePath);
+        }
+        LinkStamp = nextLinkStamp();
+        reflectUniforms();
+        BindSharedBlocks();
+    }
+
+    void compile(const std::string &vertexCode, const std::string &fragmentCode, const std::string *geometryCode, bool retrievable)
+    {
+        const char* vShaderCode = vertexCode.c_str();
+        const char * fShaderCode = fragmentCode.c_str();
+        unsigned int vertex, fragment;
+        // vertex shader
+        vertex = glCreateShader(GL_VERTEX_SHADER);
+        glShaderSource(vertex, 1, &vShaderCode, NULL);
+        glCompileShader(vertex);
+        checkCompileErrors(vertex, "VERTEX");
+        // fragment Shader
+        fragment = glCreateShader(GL_FRAGMENT_SHADER);
+        glShaderSource(fragment, 1, &fShaderCode, NULL);
+        glCompileShader(fragment);
+        checkCompileErrors(fragment, "FRAGMENT");
+        // if geometry shader is given, compile geometry shader
+        unsigned int geometry = 0;
+        if(geometryCode != nullptr)
+        {
+            const char * gShaderCode = geometryCode->c_str();
+            geometry = glCreateShader(GL_GEOMETRY_SHADER);
+            glShaderSource(geometry, 1, &gShaderCode, NULL);
+            glCompileShader(geometry);
+            checkCompileErrors(geometry, "GEOMETRY");
+        }
+        // shader Program
+        ID = glCreateProgram();
+        glAttachShader(ID, vertex);
+        glAttachShader(ID, fragment);
+        if(geometryCode != nullptr)
+            glAttachShader(ID, geometry);
+        if(retrievable)
+            glProgramParameteri(ID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+        glLinkProgram(ID);
+        checkCompileErrors(ID, "PROGRAM");
+        // delete the shaders as they're linked into our program now and no longer necessery
+        glDeleteShader(vertex);
+        glDeleteShader(fragment);
+        if(geometryCode != nullptr)
+            glDeleteShader(geometry);
+    }
+
+    // program binaries need GL 4.1 (or ARB_get_program_binary) and a driver offering at least one format
+    static bool binaryCacheSupported()
+    {
+        if(!GLAD_GL_VERSION_4_1)
+            return false;
+        GLint formats = 0;
+        glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+        return formats > 0;
+    }
+
+    // a cached binary is stored as its GLenum format followed by the driver's bytes. The driver may reject it
+    // (after an update, say), in which case the program is compiled again and the file replaced
+    bool loadBinary(const std::string &path)
+    {
+        std::ifstream file(path.c_str(), std::ios::binary);
+        if(!file)
+            return false;
+        GLenum format = 0;
+        file.read((char*)&format, sizeof(format));
+        std::vector<char> binary((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if(!file.good() && !file.eof())
+            return false;
+        if(binary.empty())
+            return false;
+        ID = glCreateProgram();
+        glProgramBinary(ID, format, &binary[0], (GLsizei)binary.size());
+        GLint success = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        if(!success)
+        {
+            glDeleteProgram(ID);
+            return false;
+        }
+        return true;
+    }
+
+    void saveBinary(const std::string &path)
+    {
+        GLint success = 0, length = 0;
+        glGetProgramiv(ID, GL_LINK_STATUS, &success);
+        glGetProgramiv(ID, GL_PROGRAM_BINARY_LENGTH, &length);
+        if(!success || length <= 0)
+            return;
+        std::vector<char> binary(length);
+        GLenum format = 0;
+        glGetProgramBinary(ID, length, NULL, &format, &binary[0]);
+        makeDirectory(ShaderCacheDirectory());
+        std::ofstream file(path.c_str(), std::ios::binary);
+        if(!file)
+            return;
+        file.write((const char*)&format, sizeof(format));
+        file.write(&binary[0], binary.size());
+    }
+
+    static std::string glString(GLenum name)
+    {
+        const GLubyte *value = glGetString(name);
+        return value ? std::string((const char*)value) : std::string();
+    }
+
+    static void makeDirectory(const std::string &path)
+    {
+#ifdef _WIN32
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
+    // active uniforms of the program, shared by every copy of this Shader so their value caches agree.
+    // A deque never moves its elements, so handles keep pointing at the right slot as names are added
+    struct UniformTable {
+        std::deque<UniformSlot> slots;
+        std::unordered_map<std::string, size_t> names;
+    };
+    std::shared_ptr<UniformTable> uniforms;
+
+    // queries every active uniform once after linking. Arrays are registered both as "name[0]" and "name"
+    // ------------------------------------------------------------------------
+    void reflectUniforms()
+    {
+        uniforms = std::make_shared<UniformTable>();
+        GLint count = 0, maxLength = 0;
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+        glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+        std::vector<GLchar> nameBuffer(maxLength > 0 ? maxLength : 1);
+        for(GLint i = 0; i < count; i++)
+        {
+            GLint size;
+            GLenum type;
+            glGetActiveUniform(ID, i, (GLsizei)nameBuffer.size(), NULL, &size, &type, &nameBuffer[0]);
+            UniformSlot slot;
+            slot.location = glGetUniformLocation(ID, &nameBuffer[0]);
+            slot.type = type;
+            slot.valid = false;
+            // uniforms inside uniform blocks have no location and can't be set this way
+            if(slot.location == -1)
+                continue;
+            std::string name(&nameBuffer[0]);
+            uniforms->names[name] = uniforms->slots.size();
+            if(name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+                uniforms->names[name.substr(0, name.size() - 3)] = uniforms->slots.size();
+            uniforms->slots.push_back(slot);
+        }
+    }
+    // hands out link stamps, zero is never returned so it can mean "not resolved yet"
+    // ------------------------------------------------------------------------
+    static unsigned int nextLinkStamp()
+    {
+        static unsigned int stamp = 0;
+        return ++stamp;
+    }
     // utility function for checking shader compilation/linking errors.
     // ------------------------------------------------------------------------
     void checkCompileErrors(GLuint shader, std::string type)
@@ -0,0 +1,105 @@
+#ifndef SHADER_LIBRARY_H
+#define SHADER_LIBRARY_H
+
+#include <learnopengl/shader.h>
+#include <learnopengl/mesh.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Owns every program built from shader files with defines. A program is compiled the first time it's asked for,
+// and only once per distinct preprocessed source: requests whose defines end up producing the same text
+// (because the shader never tests some of them) share one program
+class ShaderLibrary
+{
+public:
+    struct Stats {
+        unsigned int requests;      // distinct file and define combinations asked for
+        unsigned int programs;      // programs built for them
+        unsigned int fromCache;     // of those, loaded from the program binary cache
+    };
+
+    ShaderLibrary()
+    {
+        stats.requests = stats.programs = stats.fromCache = 0;
+    }
+
+    // returns the program built from the files with the given defines, building it on first use.
+    // The reference stays valid for the lifetime of the library
+    Shader& Get(const std::string &vertexPath, const std::string &fragmentPath, const ShaderDefines &defines = ShaderDefines())
+    {
+        std::string key = vertexPath + "|" + fragmentPath;
+        for(ShaderDefines::const_iterator it = defines.begin(); it != defines.end(); it++)
+            key += "|" + it->first + "=" + it->second;
+        std::map<std::string, Shader*>::iterator request = requests.find(key);
+        if(request != requests.end())
+            return *request->second;
+
+        ShaderSources sources = LoadShaderSources(vertexPath.c_str(), fragmentPath.c_str(), defines);
+        uint64_t hash = HashShaderSources(sources);
+        std::unique_ptr<Shader> &program = programs[hash];
+        if(!program)
+        {
+            program.reset(new Shader(sources));
+            stats.programs++;
+            if(program->LoadedFromCache)
+                stats.fromCache++;
+        }
+        stats.requests++;
+        requests[key] = program.get();
+        return *program;
+    }
+
+    const Stats& GetStats() const
+    {
+        return stats;
+    }
+
+private:
+    std::map<std::string, Shader*> requests;
+    std::unordered_map<uint64_t, std::unique_ptr<Shader>> programs;
+    Stats stats;
+};
+
+// The permutations of one vertex/fragment pair over the Shader_Feature bits. Meshes are drawn with the
+// permutation their material's features select, so only the combinations some loaded mesh uses get built
+class ShaderPermutations
+{
+public:
+    ShaderPermutations(ShaderLibrary &library, const std::string &vertexPath, const std::string &fragmentPath, const ShaderDefines &defines = ShaderDefines())
+        : library(library), vertexPath(vertexPath), fragmentPath(fragmentPath), defines(defines)
+    {
+    }
+
+    // the program for these features, built on first use
+    Shader& Get(unsigned int features)
+    {
+        std::map<unsigned int, Shader*>::iterator it = variants.find(features);
+        if(it != variants.end())
+            return *it->second;
+        ShaderDefines variantDefines = defines;
+        AddFeatureDefines(features, variantDefines);
+        Shader &shader = library.Get(vertexPath, fragmentPath, variantDefines);
+        variants[features] = &shader;
+        return shader;
+    }
+
+    // builds the permutations the meshes will be drawn with (their features plus extraFeatures) right away,
+    // so it happens while loading and not on the first frame showing them
+    void WarmUp(const vector<Mesh> &meshes, unsigned int extraFeatures = 0)
+    {
+        for(unsigned int i = 0; i < meshes.size(); i++)
+            Get(meshes[i].shaderFeatures | extraFeatures);
+    }
+
+private:
+    ShaderLibrary &library;
+    std::string vertexPath;
+    std::string fragmentPath;
+    ShaderDefines defines;
+    std::map<unsigned int, Shader*> variants;
+};
+#endif
@@ -0,0 +1,60 @@
+#ifndef SIMULATION_CLOCK_H
+#define SIMULATION_CLOCK_H
+
+// Turns the real time between frames into fixed simulation steps. Each frame, Advance adds the time that passed,
+// then Tick is called until it returns false, taking one step each time; what's left over, less than a step, is
+// Alpha of the way to the next one, for the renderer to blend the last two steps by. The simulated time is the
+// steps taken times the step length, so the same steps always give the same times whatever the frame rate
+class SimulationClock
+{
+public:
+    // step is the length of a step in seconds. A frame takes maxTicks steps at most: after a stall the simulation
+    // falls behind rather than spending every following frame catching up
+    explicit SimulationClock(double step = 1.0 / 60.0, unsigned int maxTicks = 8) : step(step), maxTicks(maxTicks), ticks(0), pending(0.0) {}
+
+    void Advance(double elapsed)
+    {
+        pending += elapsed;
+        if(pending > maxTicks * step)
+            pending = maxTicks * step;
+    }
+
+    // takes a step if one is due
+    bool Tick()
+    {
+        if(pending < step)
+            return false;
+        pending -= step;
+        ticks++;
+        return true;
+    }
+
+    // simulated time as of the last step
+    float Time() const
+    {
+        return (float)(ticks * step);
+    }
+
+    // how far the real time is past the last step, in steps: 0 right on it, nearly 1 just before the next one
+    float Alpha() const
+    {
+        return (float)(pending / step);
+    }
+
+    double Step() const
+    {
+        return step;
+    }
+
+    unsigned long long Ticks() const
+    {
+        return ticks;
+    }
+
+private:
+    double step;
+    unsigned int maxTicks;
+    unsigned long long ticks;
+    double pending;     // real time not simulated yet
+};
+#endif
@@ -0,0 +1,184 @@
+#ifndef SPLINE_H
+#define SPLINE_H
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <vector>
+
+// A cubic as the polynomial ((a * t + b) * t + c) * t + d, three multiply-adds per coordinate by Horner's rule
+struct CubicPolynomial {
+    glm::vec3 a;
+    glm::vec3 b;
+    glm::vec3 c;
+    glm::vec3 d;
+};
+
+inline glm::vec3 PolynomialPoint(const CubicPolynomial &p, float t)
+{
+    return ((p.a * t + p.b) * t + p.c) * t + p.d;
+}
+
+// How a spline follows its control points
+enum Spline_Kind {
+    SPLINE_BSPLINE,         // uniform cubic B-spline: the smoothest, passing near the points, through the first and last
+    SPLINE_CATMULL_ROM,     // through every point
+    SPLINE_BEZIER           // composite Bézier: 3n + 1 points, every third one shared by two segments and passed through
+};
+
+// The basis matrix of each kind. Row i weighs the four control points of a segment into the coefficient of t^(3 - i)
+const float SPLINE_BASIS[3][4][4] = {
+    {{-1.0f / 6.0f, 3.0f / 6.0f, -3.0f / 6.0f, 1.0f / 6.0f},
+     { 3.0f / 6.0f, -6.0f / 6.0f, 3.0f / 6.0f, 0.0f},
+     {-3.0f / 6.0f, 0.0f, 3.0f / 6.0f, 0.0f},
+     { 1.0f / 6.0f, 4.0f / 6.0f, 1.0f / 6.0f, 0.0f}},
+    {{-0.5f, 1.5f, -1.5f, 0.5f},
+     { 1.0f, -2.5f, 2.0f, -0.5f},
+     {-0.5f, 0.0f, 0.5f, 0.0f},
+     { 0.0f, 1.0f, 0.0f, 0.0f}},
+    {{-1.0f, 3.0f, -3.0f, 1.0f},
+     { 3.0f, -6.0f, 3.0f, 0.0f},
+     {-3.0f, 3.0f, 0.0f, 0.0f},
+     { 1.0f, 0.0f, 0.0f, 0.0f}}
+};
+
+// The segment's polynomial: the basis matrix times its four control points
+inline CubicPolynomial SegmentPolynomial(Spline_Kind kind, const glm::vec3 &p0, const glm::vec3 &p1, const glm::vec3 &p2, const glm::vec3 &p3)
+{
+    const float (*m)[4] = SPLINE_BASIS[kind];
+    CubicPolynomial p;
+    p.a = m[0][0] * p0 + m[0][1] * p1 + m[0][2] * p2 + m[0][3] * p3;
+    p.b = m[1][0] * p0 + m[1][1] * p1 + m[1][2] * p2 + m[1][3] * p3;
+    p.c = m[2][0] * p0 + m[2][1] * p1 + m[2][2] * p2 + m[2][3] * p3;
+    p.d = m[3][0] * p0 + m[3][1] * p1 + m[3][2] * p2 + m[3][3] * p3;
+    return p;
+}
+
+// A curve through any number of control points, from the first one at t = 0 to the last one at t = 1. Each segment
+// is turned into its polynomial once, when the spline is built, so a point costs finding the segment and a Horner
+// evaluation. The segments take the same share of t each by default, which finds the segment in constant time
+// however long the curve. With evenSpeed their share follows their length instead, so a curve run in a fixed time
+// doesn't speed up where the points are far apart. The segment is then found by a binary search among the few
+// segments in one of as many even slices of t, still constant time unless the lengths are very uneven
+class Spline
+{
+public:
+    Spline() : uniform(true), end(0.0f) {}
+
+    // B-splines and Catmull-Rom splines take 2 points or more, Bézier splines 3n + 1 (points past those are left out)
+    Spline(const std::vector<glm::vec3> &points, Spline_Kind kind, bool evenSpeed = false) : uniform(true), end(0.0f)
+    {
+        if(points.empty())
+            return;
+        end = points.back();
+        if(kind == SPLINE_BEZIER)
+        {
+            for(size_t i = 0; i + 3 < points.size(); i += 3)
+                segments.push_back(SegmentPolynomial(kind, points[i], points[i + 1], points[i + 2], points[i + 3]));
+            if(!segments.empty())
+                end = points[segments.size() * 3];
+        }
+        else
+        {
+            // one more point at each end so the curve starts and ends on the end points: Catmull-Rom repeats them,
+            // a B-spline mirrors the points next to them, since its segments start at (p0 + 4 * p1 + p2) / 6
+            std::vector<glm::vec3> padded(1, points.front());
+            padded.insert(padded.end(), points.begin(), points.end());
+            padded.push_back(points.back());
+            if(kind == SPLINE_BSPLINE && points.size() > 1)
+            {
+                padded.front() = 2.0f * points[0] - points[1];
+                padded.back() = 2.0f * points.back() - points[points.size() - 2];
+            }
+            for(size_t i = 0; i + 3 < padded.size(); i++)
+                segments.push_back(SegmentPolynomial(kind, padded[i], padded[i + 1], padded[i + 2], padded[i + 3]));
+        }
+        if(evenSpeed && segments.size() > 1)
+            timeByLength();
+    }
+
+    // the point at t, clamped to [0, 1]
+    glm::vec3 Point(float t) const
+    {
+        if(segments.empty() || t >= 1.0f)
+            return end;
+        float local;
+        unsigned int s = segment(std::max(t, 0.0f), local);
+        return PolynomialPoint(segments[s], local);
+    }
+
+    const glm::vec3& End() const
+    {
+        return end;
+    }
+
+    unsigned int SegmentCount() const
+    {
+        return segments.size();
+    }
+
+private:
+    std::vector<CubicPolynomial> segments;
+    std::vector<float> starts;      // with evenSpeed, the t each segment starts at, and 1 after the last
+    std::vector<unsigned int> slices;   // with evenSpeed, the segment at t = i / segment count, for each i
+    bool uniform;
+    glm::vec3 end;
+
+    // which segment t, in [0, 1), falls in and how far along it
+    unsigned int segment(float t, float &local) const
+    {
+        unsigned int count = segments.size();
+        if(uniform)
+        {
+            float x = t * count;
+            unsigned int s = std::min((unsigned int)x, count - 1);
+            local = x - s;
+            return s;
+        }
+        unsigned int slice = std::min((unsigned int)(t * count), count - 1);
+        std::vector<float>::const_iterator first = starts.begin() + slices[slice];
+        unsigned int s = std::upper_bound(first, starts.begin() + slices[slice + 1] + 1, t) - starts.begin() - 1;
+        s = std::min(s, count - 1);
+        local = (t - starts[s]) / (starts[s + 1] - starts[s]);
+        return s;
+    }
+
+    // gives each segment a share of t by its length, measured on a short polyline
+    void timeByLength()
+    {
+        const int steps = 8;
+        starts.assign(1, 0.0f);
+        float total = 0.0f;
+        for(size_t s = 0; s < segments.size(); s++)
+        {
+            glm::vec3 last = segments[s].d;
+            for(int i = 1; i <= steps; i++)
+            {
+                glm::vec3 point = PolynomialPoint(segments[s], (float)i / steps);
+                total += glm::length(point - last);
+                last = point;
+            }
+            starts.push_back(total);
+        }
+        // segments of no length get no time, the binary search never lands on them; a curve of no length stays uniform
+        if(total <= 0.0f)
+        {
+            starts.clear();
+            return;
+        }
+        for(size_t s = 0; s < starts.size(); s++)
+            starts[s] /= total;
+        starts.back() = 1.0f;
+        unsigned int count = segments.size();
+        slices.resize(count + 1);
+        for(unsigned int i = 0, s = 0; i <= count; i++)
+        {
+            float t = (float)i / count;
+            while(s + 1 < count && starts[s + 1] <= t)
+                s++;
+            slices[i] = s;
+        }
+        uniform = false;
+    }
+};
+#endif
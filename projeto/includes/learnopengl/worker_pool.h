@@ -0,0 +1,115 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads kept waiting for work, so splitting a loop over them costs a wake up rather than creating threads.
+// ParallelFor splits a range in chunks that the workers and the calling thread take in turn until none is left,
+// and returns once they're all done. One loop runs at a time, and only from the thread that owns the pool
+class WorkerPool
+{
+public:
+    // threads is the total counting the caller, so a pool of 1 runs everything on the calling thread
+    explicit WorkerPool(unsigned int threads = std::thread::hardware_concurrency()) : job(nullptr), count(0), chunk(1), generation(0), busy(0), stopping(false)
+    {
+        if(threads == 0)
+            threads = 1;
+        for(unsigned int i = 1; i < threads; i++)
+            workers.push_back(std::thread(&WorkerPool::work, this));
+    }
+
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for(size_t i = 0; i < workers.size(); i++)
+            workers[i].join();
+    }
+
+    unsigned int Threads() const
+    {
+        return workers.size() + 1;
+    }
+
+    // calls job(begin, end) on consecutive chunks covering [0, count). Chunks have minChunk items at least, fewer
+    // than that isn't worth waking a thread for; ranges too small for two chunks run right here
+    void ParallelFor(unsigned int count, unsigned int minChunk, const std::function<void(unsigned int, unsigned int)> &job)
+    {
+        if(count == 0)
+            return;
+        // a few chunks per thread, so one slow thread doesn't hold the others up
+        unsigned int chunkSize = std::max(minChunk, (count + Threads() * 4 - 1) / (Threads() * 4));
+        if(workers.empty() || chunkSize >= count)
+        {
+            job(0, count);
+            return;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            this->job = &job;
+            this->count = count;
+            chunk = chunkSize;
+            next = 0;
+            busy = workers.size();
+            generation++;
+        }
+        wake.notify_all();
+        runChunks();
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [this]() { return busy == 0; });
+        this->job = nullptr;
+    }
+
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake, done;
+    const std::function<void(unsigned int, unsigned int)> *job;
+    unsigned int count, chunk;
+    std::atomic<unsigned int> next;     // first item not taken yet
+    unsigned int generation;            // loops started, tells the workers a new one is there
+    unsigned int busy;                  // workers still in the current loop
+    bool stopping;
+
+    void runChunks()
+    {
+        for(;;)
+        {
+            unsigned int begin = next.fetch_add(chunk);
+            if(begin >= count)
+                return;
+            (*job)(begin, std::min(begin + chunk, count));
+        }
+    }
+
+    void work()
+    {
+        unsigned int seen = 0;
+        for(;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wake.wait(lock, [this, seen]() { return stopping || generation != seen; });
+                if(stopping)
+                    return;
+                seen = generation;
+            }
+            runChunks();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy--;
+            }
+            done.notify_one();
+        }
+    }
+};
+#endif
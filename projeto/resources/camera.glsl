@@ -0,0 +1,8 @@
+// camera matrices, shared by every program through the uniform block bound to CAMERA_BLOCK_BINDING
+layout (std140) uniform Camera
+{
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+};
@@ -2,15 +2,25 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+#ifdef SHADER_INSTANCED
+layout (location = 5) in mat4 aInstanceMatrix;
+#else
+uniform mat4 model;
+#endif
 
 out vec2 TexCoords;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#include "camera.glsl"
+
+// matches the depth pre-pass exactly
+invariant gl_Position;
 
 void main()
 {
     TexCoords = aTexCoords;    
-    gl_Position = projection * view * model * vec4(aPos, 1.0);
+#ifdef SHADER_INSTANCED
+    gl_Position = viewProjection * aInstanceMatrix * vec4(aPos, 1.0);
+#else
+    gl_Position = viewProjection * model * vec4(aPos, 1.0);
+#endif
 }
\ No newline at end of file
@@ -0,0 +1,6 @@
+#version 330 core
+
+// depth only, color writes are masked off
+void main()
+{
+}
\ No newline at end of file
@@ -0,0 +1,13 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 5) in mat4 aInstanceMatrix;
+
+#include "camera.glsl"
+
+// the depth pre-pass and the shaded pass must agree on every depth value
+invariant gl_Position;
+
+void main()
+{
+    gl_Position = viewProjection * aInstanceMatrix * vec4(aPos, 1.0);
+}
\ No newline at end of file
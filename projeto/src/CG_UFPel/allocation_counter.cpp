@@ -0,0 +1,126 @@
+#include <learnopengl/allocation_counter.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// The global operator new and delete, replaced by versions counting what they allocate for allocation_counter.h.
+// A program defines them once, so they live in this file of the executable. Every form C++11 has is replaced,
+// the nothrow ones included; built as C++17, the aligned forms are replaced as well
+
+static void countAllocation(std::size_t size)
+{
+    allocationCount().fetch_add(1, std::memory_order_relaxed);
+    allocationBytes().fetch_add(size, std::memory_order_relaxed);
+}
+
+static void* countedAllocation(std::size_t size)
+{
+    countAllocation(size);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size)
+{
+    void *p = countedAllocation(size);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocation(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    return countedAllocation(size);
+}
+
+void operator delete(void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept
+{
+    std::free(p);
+}
+
+void operator delete(void *p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t&) noexcept
+{
+    std::free(p);
+}
+
+#ifdef __cpp_aligned_new
+// malloc'ed with room to align the block, the pointer malloc gave kept just before it
+static void* countedAlignedAllocation(std::size_t size, std::align_val_t alignment)
+{
+    countAllocation(size);
+    std::size_t align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    void *block = std::malloc(size + align + sizeof(void*));
+    if(!block)
+        return nullptr;
+    std::uintptr_t aligned = (reinterpret_cast<std::uintptr_t>(block) + sizeof(void*) + align - 1) & ~(std::uintptr_t)(align - 1);
+    reinterpret_cast<void**>(aligned)[-1] = block;
+    return reinterpret_cast<void*>(aligned);
+}
+
+static void freeAligned(void *p)
+{
+    if(p)
+        std::free(static_cast<void**>(p)[-1]);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+    void *p = countedAlignedAllocation(size, alignment);
+    if(!p)
+        throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return operator new(size, alignment);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAllocation(size, alignment);
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return countedAlignedAllocation(size, alignment);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept                                 { freeAligned(p); }
+void operator delete[](void *p, std::align_val_t) noexcept                               { freeAligned(p); }
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept                    { freeAligned(p); }
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept                  { freeAligned(p); }
+void operator delete(void *p, std::align_val_t, const std::nothrow_t&) noexcept          { freeAligned(p); }
+void operator delete[](void *p, std::align_val_t, const std::nothrow_t&) noexcept        { freeAligned(p); }
+#endif
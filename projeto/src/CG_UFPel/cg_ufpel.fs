@@ -3,9 +3,16 @@ out vec4 FragColor;
 
 in vec2 TexCoords;
 
+#ifdef SHADER_DIFFUSE_MAP
 uniform sampler2D texture_diffuse1;
+#endif
 
 void main()
 {    
+#ifdef SHADER_DIFFUSE_MAP
     FragColor = texture(texture_diffuse1, TexCoords);
+#else
+    // untextured materials (or models imported without them) get a flat grey
+    FragColor = vec4(0.8, 0.8, 0.8, 1.0);
+#endif
 }
\ No newline at end of file
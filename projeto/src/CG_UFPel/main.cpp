@@ -6,20 +6,37 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include <learnopengl/filesystem.h>
-#include <learnopengl/shader_m.h>
+#include <learnopengl/shader.h>
+#include <learnopengl/shader_library.h>
 #include <learnopengl/camera.h>
+#include <learnopengl/camera_block.h>
 #include <learnopengl/model.h>
+#include <learnopengl/benchmark.h>
+#include <learnopengl/animation_checks.h>
+#include <learnopengl/frame_profiler.h>
+#include <learnopengl/scene_script.h>
+#include <learnopengl/allocation_counter.h>
+#include <learnopengl/worker_pool.h>
+#include <learnopengl/simulation_clock.h>
 
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
 void processInput(GLFWwindow *window);
+void warmUpShaders(ShaderPermutations &shaders, const ShaderLibrary &library, const vector<Mesh> &meshes);
+int runScriptedBenchmark(GLFWwindow *window, const SceneScript &script, vector<Model> &models, CameraUniformBlock &cameraBlock,
+                         ShaderPermutations &shaders, FrameRingBuffer &frameData, RenderQueue &renderQueue, SimulationClock &clock, const char *csvPath);
 
 // settings
 const unsigned int SCR_WIDTH = 800;
 const unsigned int SCR_HEIGHT = 600;
+// rocks added to the asteroid field on each key press
+const unsigned int ASTEROID_BATCH = 10000;
 
 // camera
 Camera camera(glm::vec3(0.0f, 0.0f, 3.0f));
@@ -31,23 +48,68 @@ bool firstMouse = true;
 float deltaTime = 0.0f;
 float lastFrame = 0.0f;
 
-int main()
+int main(int argc, char **argv)
 {
+    // command line: --headless <scene> renders a scene script without showing a window and exits,
+    // --frames <count> overrides the script's frame count and --csv <file> records every frame.
+    // --tickrate <hz> sets how many steps a second the animations are simulated at, whatever the frame rate.
+    // --check runs the animation checks and exits, with a non-zero status if any of them failed
+    // ------------------------------
+    const char *scenePath = NULL, *csvPath = NULL;
+    int frameCount = 0;
+    double tickRate = 60.0;
+    for (int i = 1; i < argc; i++){
+        if (strcmp(argv[i], "--headless") == 0 && i + 1 < argc)
+            scenePath = argv[++i];
+        else if (strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+            frameCount = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--csv") == 0 && i + 1 < argc)
+            csvPath = argv[++i];
+        else if (strcmp(argv[i], "--tickrate") == 0 && i + 1 < argc && atof(argv[i + 1]) > 0.0)
+            tickRate = atof(argv[++i]);
+        else if (strcmp(argv[i], "--check") == 0)
+            return CheckAnimation() ? 0 : 1;
+        else {
+            printf("usage: %s [--check] [--tickrate <hz>] [--headless <scene> [--frames <count>] [--csv <file>]]\n", argv[0]);
+            return -1;
+        }
+    }
+    bool headless = scenePath != NULL;
+
     // glfw: initialize and configure
     // ------------------------------
+#ifdef GLFW_PLATFORM_NULL
+    // with no display at all (a CI box), GLFW 3.4 can run without a window system and render through OSMesa
+    if (headless && !getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY"))
+        glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
     glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
     glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
     glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
     glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // uncomment this statement to fix compilation on OS X
 #endif
+    if (headless){
+        // an invisible window still gets a context; under Xvfb that's Mesa's llvmpipe, no GPU needed
+        glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+#if defined(GLFW_CONTEXT_CREATION_API) && defined(GLFW_OSMESA_CONTEXT_API)
+        if (!getenv("DISPLAY") && !getenv("WAYLAND_DISPLAY"))
+            glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_OSMESA_CONTEXT_API);
+#endif
+    }
 
-    // glfw window creation
+    // glfw window creation, asking for 4.3 to get multi-draw indirect and settling for 3.3 otherwise
     // --------------------
     GLFWwindow* window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
     if (window == NULL)
+    {
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        window = glfwCreateWindow(SCR_WIDTH, SCR_HEIGHT, "LearnOpenGL", NULL, NULL);
+    }
+    if (window == NULL)
     {
         std::cout << "Failed to create GLFW window" << std::endl;
         glfwTerminate();
@@ -73,9 +135,39 @@ int main()
     // -----------------------------
     glEnable(GL_DEPTH_TEST);
 
-    // build and compile shaders
+    // camera matrices shared by every shader, created first so the shaders are bound to it when linked
+    CameraUniformBlock cameraBlock;
+
+    // shaders are built per permutation when a loaded model first needs it, reusing the binaries cached by earlier runs
     // -------------------------
-    Shader ourShader(FileSystem::getPath("resources/cg_ufpel.vs").c_str(), FileSystem::getPath("resources/cg_ufpel.fs").c_str());
+    ShaderCacheDirectory() = FileSystem::getPath("shader_cache");
+    ShaderLibrary shaderLibrary;
+    ShaderPermutations modelShaders(shaderLibrary, FileSystem::getPath("resources/cg_ufpel.vs"), FileSystem::getPath("resources/cg_ufpel.fs"));
+    FrameRingBuffer frameData;
+    RenderQueue renderQueue(frameData);
+    renderQueue.MultiDraw = GLAD_GL_VERSION_4_3 != 0;
+    printf("OpenGL %s, %s draw path\n", (const char*)glGetString(GL_VERSION), renderQueue.UsingMultiDraw() ? "multi-draw indirect" : "per mesh");
+    // the update phase advances every animation before anything is submitted, split across the cores
+    WorkerPool animationWorkers;
+    Animations().Workers = &animationWorkers;
+    // the animations advance in fixed steps, and each frame shows them blended between the last two
+    SimulationClock simulationClock(1.0 / tickRate);
+
+    if (headless){
+        SceneScript script;
+        vector<Model> sceneModels;
+        if (!LoadSceneScript(scenePath, script, sceneModels)){
+            glfwTerminate();
+            return -1;
+        }
+        if (frameCount > 0)
+            script.frames = frameCount;
+        for (size_t i = 0; i < sceneModels.size(); i++)
+            modelShaders.WarmUp(sceneModels[i].asset->meshes, SHADER_INSTANCED);
+        int result = runScriptedBenchmark(window, script, sceneModels, cameraBlock, modelShaders, frameData, renderQueue, simulationClock, csvPath);
+        glfwTerminate();
+        return result;
+    }
     
     // draw in wireframe
     //glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
@@ -87,7 +179,21 @@ int main()
     bool r1 = false, r2 = false, r3 = false, r4 = false;
     bool sh1 = false, sh2 = false, sh3 = false, sh4 = false;
     bool obj1 = false, obj2 = false, obj3 = false, obj4 = false, obj5 = false;
-    bool createModel = false;
+    bool createModel = false, createAsteroids = false;
+    bool chooseProfile = false, benchmark = false, benchmarkUniforms = false, benchmarkAnimation = false, reportIndices = false;
+    bool reportAllocations = false, toggleAllocations = false;
+    AllocationStats frameAllocations = {0, 0};
+    int allocationFrames = 0;
+    float lastAllocationReport = 0.0f;
+    bool reportStats = false, toggleStats = false, toggleSorting = false, toggleMultiDraw = false, toggleDepthPrepass = false, toggleWorkers = false;
+    RenderStats frameStats = RenderStats();
+    int statsFrames = 0;
+    float lastStatsReport = 0.0f;
+    // where frames go, always measured; F9 prints it every second and F10 records it to frame_profile.csv
+    FrameProfiler profiler;
+    bool reportProfile = false, toggleProfile = false, recordProfile = false, toggleRecording = false;
+    float lastProfileReport = 0.0f;
+    Import_Profile importProfile = IMPORT_FULL_QUALITY;
     vector<Model> models;
     char path[100];
     strcpy(path, "resources/objects/rock/rock.obj");
@@ -101,6 +207,7 @@ int main()
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        profiler.BeginFrame();
 
         // input
         // -----
@@ -138,6 +245,106 @@ int main()
             obj5 = false;
         }
 
+        // Choose import profile
+        if (glfwGetKey(window, GLFW_KEY_L) == GLFW_PRESS)   chooseProfile = true;
+        if (glfwGetKey(window, GLFW_KEY_L) == GLFW_RELEASE && chooseProfile){
+            importProfile = (Import_Profile)((importProfile + 1) % IMPORT_PROFILE_COUNT);
+            printf("Current import profile: %s\n", GetImportSettings(importProfile).name);
+            chooseProfile = false;
+        }
+
+        // Benchmark
+        if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_PRESS)   benchmark = true;
+        if (glfwGetKey(window, GLFW_KEY_F1) == GLFW_RELEASE && benchmark){
+            BenchmarkImportProfiles();
+            benchmark = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_PRESS)   benchmarkUniforms = true;
+        if (glfwGetKey(window, GLFW_KEY_F2) == GLFW_RELEASE && benchmarkUniforms){
+            BenchmarkUniforms(modelShaders.Get(SHADER_DIFFUSE_MAP | SHADER_INSTANCED));
+            benchmarkUniforms = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F11) == GLFW_PRESS)   benchmarkAnimation = true;
+        if (glfwGetKey(window, GLFW_KEY_F11) == GLFW_RELEASE && benchmarkAnimation){
+            BenchmarkAnimation();
+            BenchmarkCurves();
+            benchmarkAnimation = false;
+        }
+
+        if (glfwGetKey(window, GLFW_KEY_F9) == GLFW_PRESS)   toggleProfile = true;
+        if (glfwGetKey(window, GLFW_KEY_F9) == GLFW_RELEASE && toggleProfile){
+            reportProfile = !reportProfile;
+            printf("Frame profile %s\n", reportProfile ? "on" : "off");
+            lastProfileReport = currentFrame;
+            toggleProfile = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F10) == GLFW_PRESS)   toggleRecording = true;
+        if (glfwGetKey(window, GLFW_KEY_F10) == GLFW_RELEASE && toggleRecording){
+            recordProfile = !recordProfile;
+            if (recordProfile && !profiler.OpenCsv("frame_profile.csv")){
+                printf("Could not open frame_profile.csv\n");
+                recordProfile = false;
+            }
+            if (!recordProfile)
+                profiler.CloseCsv();
+            printf("Frame profile recording %s\n", recordProfile ? "on" : "off");
+            toggleRecording = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F8) == GLFW_PRESS)   reportIndices = true;
+        if (glfwGetKey(window, GLFW_KEY_F8) == GLFW_RELEASE && reportIndices){
+            ReportIndexMemory();
+            reportIndices = false;
+        }
+        // Report heap allocations made while rendering, which should be none once nothing is loading
+        if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_PRESS)   toggleAllocations = true;
+        if (glfwGetKey(window, GLFW_KEY_F3) == GLFW_RELEASE && toggleAllocations){
+            reportAllocations = !reportAllocations;
+            printf("Allocation report %s\n", reportAllocations ? "on" : "off");
+            frameAllocations.count = frameAllocations.bytes = 0;
+            allocationFrames = 0;
+            lastAllocationReport = currentFrame;
+            toggleAllocations = false;
+        }
+
+        // Report the state changes made per frame, and turn draw sorting on and off to compare
+        if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_PRESS)   toggleStats = true;
+        if (glfwGetKey(window, GLFW_KEY_F4) == GLFW_RELEASE && toggleStats){
+            reportStats = !reportStats;
+            printf("Render stats %s\n", reportStats ? "on" : "off");
+            frameStats = RenderStats();
+            statsFrames = 0;
+            lastStatsReport = currentFrame;
+            toggleStats = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_PRESS)   toggleSorting = true;
+        if (glfwGetKey(window, GLFW_KEY_F5) == GLFW_RELEASE && toggleSorting){
+            renderQueue.Sorting = !renderQueue.Sorting;
+            printf("Draw sorting %s\n", renderQueue.Sorting ? "on" : "off");
+            toggleSorting = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_PRESS)   toggleMultiDraw = true;
+        if (glfwGetKey(window, GLFW_KEY_F6) == GLFW_RELEASE && toggleMultiDraw){
+            renderQueue.MultiDraw = !renderQueue.MultiDraw;
+            printf("Draw path: %s\n", renderQueue.UsingMultiDraw() ? "multi-draw indirect" : "per mesh");
+            toggleMultiDraw = false;
+        }
+        // depth pre-pass: compare overdraw heavy scenes (the asteroid field seen edge on) with it on and off
+        if (glfwGetKey(window, GLFW_KEY_F7) == GLFW_PRESS)   toggleDepthPrepass = true;
+        if (glfwGetKey(window, GLFW_KEY_F7) == GLFW_RELEASE && toggleDepthPrepass){
+            if (renderQueue.DepthPrepass)
+                renderQueue.DepthPrepass = nullptr;
+            else
+                renderQueue.DepthPrepass = &shaderLibrary.Get(FileSystem::getPath("resources/depth.vs"), FileSystem::getPath("resources/depth.fs"));
+            printf("Depth pre-pass %s\n", renderQueue.DepthPrepass ? "on" : "off");
+            toggleDepthPrepass = false;
+        }
+        if (glfwGetKey(window, GLFW_KEY_F12) == GLFW_PRESS)   toggleWorkers = true;
+        if (glfwGetKey(window, GLFW_KEY_F12) == GLFW_RELEASE && toggleWorkers){
+            Animations().Workers = Animations().Workers ? nullptr : &animationWorkers;
+            printf("Animation update on %u thread(s)\n", Animations().Workers ? animationWorkers.Threads() : 1);
+            toggleWorkers = false;
+        }
+
         // Choose Model
 
         // Advances to next model on the list
@@ -169,9 +376,23 @@ int main()
             // load model
             // -----------
             createModel = false;
-            Model ourModel(FileSystem::getPath(path));
+            double start = glfwGetTime();
+            Model ourModel(FileSystem::getPath(path), false, importProfile);
+            printf("Loaded %s (%s) in %.2f ms\n", path, GetImportSettings(importProfile).name, (glfwGetTime() - start) * 1000.0);
+            warmUpShaders(modelShaders, shaderLibrary, ourModel.asset->meshes);
             models.push_back(ourModel);
         }
+
+        // Create asteroid field: rocks scattered on a ring around the origin. They all share the same asset,
+        // so the whole field is drawn with one instanced draw per mesh
+        if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_PRESS)   createAsteroids = true;
+        if (glfwGetKey(window, GLFW_KEY_Z) == GLFW_RELEASE && createAsteroids) {
+            createAsteroids = false;
+            Model rock(FileSystem::getPath("resources/objects/rock/rock.obj"), false, importProfile);
+            warmUpShaders(modelShaders, shaderLibrary, rock.asset->meshes);
+            AddAsteroidField(models, rock, ASTEROID_BATCH, rand());
+            printf("Asteroid field: %zu models\n", models.size());
+        }
          
         // Shear
         if (glfwGetKey(window, GLFW_KEY_U) == GLFW_PRESS && models.size() > 0)   sh1 = true;
@@ -272,26 +493,68 @@ int main()
         }
             
 
+        profiler.EndPhase(PHASE_INPUT);
+
+        // update: the steps due by now, then where every model is this frame between the last two
+        // ------
+        simulationClock.Advance(deltaTime);
+        while (simulationClock.Tick())
+            Animations().Step(simulationClock.Time());
+        Animations().Interpolate(simulationClock.Alpha());
+        profiler.EndPhase(PHASE_UPDATE);
+
         // render
         // ------
+        AllocationStats renderStart = GetAllocationStats();
+        profiler.BeginGpu();
         glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-        // don't forget to enable shader before setting uniforms
-        ourShader.use();
-
-        // view/projection transformations
-        glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
-        glm::mat4 view = camera.GetViewMatrix();
-        ourShader.setMat4("projection", projection);
-        ourShader.setMat4("view", view);
-
+        // view/projection transformations, uploaded only when the camera moved
+        cameraBlock.Update(camera, (float)SCR_WIDTH / (float)SCR_HEIGHT, 0.1f, 100.0f);
+
+
+        // render the loaded models, sorted by the state they need
+        frameData.BeginFrame();
+        renderQueue.Begin(cameraBlock.Data.view, 100.0f);
+        for(size_t i = 0; i < models.size(); i++)
+            models[i].Submit(renderQueue, modelShaders, models[i].WorldMatrix());
+        renderQueue.Flush();
+        frameData.EndFrame();
+        profiler.EndGpu();
+        profiler.EndPhase(PHASE_SUBMIT);
+
+        if (reportStats){
+            frameStats.apiCalls += renderQueue.Stats.apiCalls;
+            frameStats.drawCalls += renderQueue.Stats.drawCalls;
+            frameStats.instances += renderQueue.Stats.instances;
+            frameStats.programChanges += renderQueue.Stats.programChanges;
+            frameStats.materialChanges += renderQueue.Stats.materialChanges;
+            frameStats.vaoChanges += renderQueue.Stats.vaoChanges;
+            frameStats.textureBinds += renderQueue.Stats.textureBinds;
+            statsFrames++;
+            if (currentFrame - lastStatsReport >= 1.0f){
+                printf("Per frame: %.1f GL calls, %.1f draws (%.1f instances), %.1f program, %.1f material, %.1f VAO changes, %.1f texture binds\n",
+                    (float)frameStats.apiCalls / statsFrames, (float)frameStats.drawCalls / statsFrames, (float)frameStats.instances / statsFrames, (float)frameStats.programChanges / statsFrames,
+                    (float)frameStats.materialChanges / statsFrames, (float)frameStats.vaoChanges / statsFrames,
+                    (float)frameStats.textureBinds / statsFrames);
+                frameStats = RenderStats();
+                statsFrames = 0;
+                lastStatsReport = currentFrame;
+            }
+        }
 
-        // render the loaded models
-        for(size_t i = 0; i < models.size(); i++){
-            glm::mat4 model = models[i].TrasformationMatrix(currentFrame);
-            ourShader.setMat4("model", model);
-            models[i].Draw(ourShader);    
+        if (reportAllocations){
+            AllocationStats rendered = GetAllocationStats() - renderStart;
+            frameAllocations.count += rendered.count;
+            frameAllocations.bytes += rendered.bytes;
+            allocationFrames++;
+            if (currentFrame - lastAllocationReport >= 1.0f){
+                printf("Rendering %d frames allocated %zu bytes in %zu allocations\n", allocationFrames, frameAllocations.bytes, frameAllocations.count);
+                frameAllocations.count = frameAllocations.bytes = 0;
+                allocationFrames = 0;
+                lastAllocationReport = currentFrame;
+            }
         }
 
 
@@ -299,6 +562,12 @@ int main()
         // -------------------------------------------------------------------------------
         glfwSwapBuffers(window);
         glfwPollEvents();
+        profiler.EndPhase(PHASE_SWAP);
+        profiler.EndFrame();
+        if (reportProfile && currentFrame - lastProfileReport >= 1.0f){
+            profiler.Print();
+            lastProfileReport = currentFrame;
+        }
     }
 
     // glfw: terminate, clearing all previously allocated GLFW resources.
@@ -327,6 +596,87 @@ void processInput(GLFWwindow *window)
 
 }
 
+// builds the shader permutations the meshes are drawn with now, rather than on the first frame showing them
+// ---------------------------------------------------------------------------------------------------------
+void warmUpShaders(ShaderPermutations &shaders, const ShaderLibrary &library, const vector<Mesh> &meshes)
+{
+    unsigned int programs = library.GetStats().programs;
+    double start = glfwGetTime();
+    shaders.WarmUp(meshes, SHADER_INSTANCED);
+    if(library.GetStats().programs == programs)
+        return;
+    const ShaderLibrary::Stats &stats = library.GetStats();
+    printf("Built %u shader permutations in %.2f ms; %u programs (%u from the binary cache) for %u requests\n",
+           stats.programs - programs, (glfwGetTime() - start) * 1000.0, stats.programs, stats.fromCache, stats.requests);
+}
+
+// renders the script's frames as fast as possible with simulated time, then prints the frame time percentiles.
+// Each frame is finished before the next starts, so its time includes the GPU's work
+// ---------------------------------------------------------------------------------------------------------
+int runScriptedBenchmark(GLFWwindow *window, const SceneScript &script, vector<Model> &models, CameraUniformBlock &cameraBlock,
+                         ShaderPermutations &shaders, FrameRingBuffer &frameData, RenderQueue &renderQueue, SimulationClock &clock, const char *csvPath)
+{
+    if (script.hasCamera)
+        camera = Camera(script.cameraPosition, glm::vec3(0.0f, 1.0f, 0.0f), script.yaw, script.pitch);
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    glViewport(0, 0, width, height);
+
+    FrameProfiler profiler;
+    if (csvPath && !profiler.OpenCsv(csvPath))
+        printf("Could not open %s\n", csvPath);
+    vector<double> frameTimes;
+    frameTimes.reserve(script.frames);
+    // the scene as loaded, at time 0
+    Animations().Step(clock.Time());
+    double start = BenchmarkNow();
+    for (unsigned int frame = 0; frame < script.frames; frame++){
+        profiler.BeginFrame();
+        profiler.EndPhase(PHASE_INPUT);
+
+        // the first frame shows time 0, every later one a timestep further
+        if (frame > 0)
+            clock.Advance(script.timestep);
+        while (clock.Tick())
+            Animations().Step(clock.Time());
+        Animations().Interpolate(clock.Alpha());
+        profiler.EndPhase(PHASE_UPDATE);
+
+        profiler.BeginGpu();
+        glClearColor(0.05f, 0.05f, 0.05f, 1.0f);
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        cameraBlock.Update(camera, (float)width / (float)height, 0.1f, 100.0f);
+        frameData.BeginFrame();
+        renderQueue.Begin(cameraBlock.Data.view, 100.0f);
+        for (size_t i = 0; i < models.size(); i++)
+            models[i].Submit(renderQueue, shaders, models[i].WorldMatrix());
+        renderQueue.Flush();
+        frameData.EndFrame();
+        profiler.EndGpu();
+        profiler.EndPhase(PHASE_SUBMIT);
+
+        // nothing is shown, so instead of swapping wait for the frame to be done
+        glFinish();
+        profiler.EndPhase(PHASE_SWAP);
+        profiler.EndFrame();
+        frameTimes.push_back(profiler.FrameStats().last);
+
+        if (std::find(script.dumpFrames.begin(), script.dumpFrames.end(), frame) != script.dumpFrames.end()){
+            char name[64];
+            snprintf(name, sizeof(name), "frame_%05u.ppm", frame);
+            if (!SaveFramebufferImage(name, width, height))
+                printf("Could not write %s\n", name);
+        }
+    }
+    double total = BenchmarkNow() - start;
+
+    printf("%u frames, %zu models, %.1f ms (%.1f fps)\n", script.frames, models.size(), total, script.frames * 1000.0 / total);
+    printf("Frame time p50 %.3f ms, p90 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+           Percentile(frameTimes, 50), Percentile(frameTimes, 90), Percentile(frameTimes, 95), Percentile(frameTimes, 99), Percentile(frameTimes, 100));
+    profiler.Print();
+    return 0;
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)